@@ -0,0 +1,371 @@
+// Graph-shape benchmark for libengine, driven through the public C API.
+//
+//   ./engine_bench [--topology chain,tree,...] [--sizes 10,1000,...]
+//                  [--min-time SEC] [--max-runs N] [--no-fork] [--list]
+//
+// Every (topology, size) case runs in a forked child so peak RSS is per case,
+// and prints one JSON object per line on stdout:
+//   {"bench":"chain","nodes":..,"edges":..,"build_ms":..,"first_run_ms":..,
+//    "run_ms":{"min":..,"p50":..,"p95":..},"runs":..,"nodes_per_sec":..,
+//    "peak_rss_kb":..,"build_allocs":..,"allocs_per_run":..,
+//    "alloc_bytes_per_run":..,"threads":..,"catalog":".."}
+// Runs are incremental, so each steady-state iteration rewrites every source
+// parameter first; every node is recomputed on every measured run.
+// Allocation counts cover operator new (the engine's C++ heap traffic), not
+// malloc calls made by LuaJIT.
+
+#include "engine_api.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// ========= allocation counting =========
+// Replacing the global operator new here also interposes it for libengine.so.
+
+static std::atomic<uint64_t> g_allocs{0};
+static std::atomic<uint64_t> g_allocBytes{0};
+
+void* operator new(size_t n) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    g_allocBytes.fetch_add(n, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t n) { return ::operator new(n); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+double nowMs() {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ========= graph construction =========
+
+struct Bench {
+    engine_graph_t g = engine_graph_create();
+    int nextId = 1;
+    size_t edges = 0;
+    std::vector<engine_param_t> numberSources;
+    std::vector<engine_param_t> stringSources;
+
+    ~Bench() { engine_graph_destroy(g); }
+
+    int node(const char* type) {
+        const int id = nextId++;
+        if (engine_graph_add_node_with_id(g, id, type, "") != 0) fail("add_node");
+        return id;
+    }
+    int number(double v) {
+        const int id = node("Number");
+        engine_param_t p = engine_graph_param_handle(g, id, "value");
+        if (!p || engine_param_set_number(p, v) != 0) fail("Number.value");
+        numberSources.push_back(p);
+        return id;
+    }
+    int string(const char* text) {
+        const int id = node("String");
+        engine_param_t p = engine_graph_param_handle(g, id, "text");
+        if (!p || engine_param_set_string(p, text) != 0) fail("String.text");
+        stringSources.push_back(p);
+        return id;
+    }
+    void connect(int from, int to, int input) {
+        if (engine_graph_connect(g, from, 0, to, input) != 0) fail("connect");
+        ++edges;
+    }
+    int unary(const char* type, int a) {
+        const int id = node(type);
+        connect(a, id, 0);
+        return id;
+    }
+    int binary(const char* type, int a, int b) {
+        const int id = node(type);
+        connect(a, id, 0);
+        connect(b, id, 1);
+        return id;
+    }
+    void output(int id) {
+        if (engine_graph_add_output(g, id, 0) != 0) fail("add_output");
+    }
+    size_t nodes() const { return (size_t)(nextId - 1); }
+
+    // Pairwise Add reduction of `level` down to a single node.
+    int reduce(std::vector<int> level) {
+        while (level.size() > 1) {
+            std::vector<int> next;
+            next.reserve(level.size() / 2 + 1);
+            for (size_t i = 0; i + 1 < level.size(); i += 2) next.push_back(binary("Add", level[i], level[i + 1]));
+            if (level.size() % 2) next.push_back(level.back());
+            level.swap(next);
+        }
+        return level[0];
+    }
+
+    // Makes every source dirty so the next run recomputes the whole graph.
+    void touch(uint64_t iter) {
+        for (engine_param_t p : numberSources) engine_param_set_number(p, (double)(iter % 1000));
+        for (engine_param_t p : stringSources) engine_param_set_string(p, (iter & 1) ? "abcdefghijklmnop" : "ponmlkjihgfedcba");
+    }
+
+    [[noreturn]] static void fail(const char* what) {
+        std::fprintf(stderr, "engine_bench: %s: %s\n", what, engine_last_error());
+        std::exit(2);
+    }
+};
+
+// Number -> OutputNumber -> OutputNumber -> ... (depth n-1)
+void buildChain(Bench& b, size_t n) {
+    int cur = b.number(1.0);
+    while (b.nodes() < n) cur = b.unary("OutputNumber", cur);
+    b.output(cur);
+}
+
+// One source broadcast to a wide layer, gathered by an Add reduction.
+void buildFanout(Bench& b, size_t n) {
+    const int src = b.number(1.0);
+    const size_t width = std::max<size_t>(1, n / 2);
+    std::vector<int> mids;
+    mids.reserve(width);
+    for (size_t i = 0; i < width; ++i) mids.push_back(b.unary("OutputNumber", src));
+    b.output(b.reduce(std::move(mids)));
+}
+
+// Repeated diamonds: top -> (left, right) -> Add -> next top.
+void buildDiamond(Bench& b, size_t n) {
+    int top = b.number(1.0);
+    while (b.nodes() + 3 <= n) {
+        const int l = b.unary("OutputNumber", top);
+        const int r = b.unary("OutputNumber", top);
+        top = b.binary("Add", l, r);
+    }
+    b.output(top);
+}
+
+// n/2 Number leaves reduced by a balanced binary tree of Adds.
+void buildTree(Bench& b, size_t n) {
+    const size_t leaves = std::max<size_t>(1, (n + 1) / 2);
+    std::vector<int> level;
+    level.reserve(leaves);
+    for (size_t i = 0; i < leaves; ++i) level.push_back(b.number((double)i));
+    b.output(b.reduce(std::move(level)));
+}
+
+// sqrt(n) layers of sqrt(n) Adds, each reading two random nodes of the
+// previous layer (fixed seed, so every run of the bench builds the same DAG).
+void buildLayered(Bench& b, size_t n) {
+    const size_t width = std::max<size_t>(2, (size_t)std::sqrt((double)n));
+    std::mt19937_64 rng(42);
+    std::vector<int> prev, cur;
+    for (size_t i = 0; i < width; ++i) prev.push_back(b.number((double)i));
+    while (b.nodes() + width <= n) {
+        cur.clear();
+        std::uniform_int_distribution<size_t> pick(0, prev.size() - 1);
+        for (size_t i = 0; i < width; ++i) cur.push_back(b.binary("Add", prev[pick(rng)], prev[pick(rng)]));
+        prev.swap(cur);
+    }
+    b.output(prev[0]);
+}
+
+// Independent Concat lanes of depth 32, all appending one shared 16-byte
+// String source; lane strings end up ~0.5 KB.
+void buildConcat(Bench& b, size_t n) {
+    const int seed = b.string("abcdefghijklmnop");
+    const size_t depth = 32;
+    bool first = true;
+    while (b.nodes() < n) {
+        int cur = seed;
+        for (size_t d = 0; d < depth && b.nodes() < n; ++d) cur = b.binary("Concat", cur, seed);
+        if (first) b.output(cur);
+        first = false;
+    }
+}
+
+struct Topology {
+    const char* name;
+    void (*build)(Bench&, size_t);
+};
+
+const Topology kTopologies[] = {
+    {"chain", buildChain},   {"fanout", buildFanout},   {"diamond", buildDiamond},
+    {"tree", buildTree},     {"layered", buildLayered}, {"concat", buildConcat},
+};
+
+// ========= measurement =========
+
+struct Options {
+    std::vector<std::string> topologies;
+    std::vector<size_t> sizes{10, 100, 1000, 10000, 100000, 1000000};
+    double minTimeMs = 1000.0;
+    size_t maxRuns = 1000;
+    bool fork = true;
+};
+
+size_t engineThreads() {
+    const char* env = std::getenv("TAZOR_ENGINE_THREADS");
+    const long n = env ? std::strtol(env, nullptr, 10) : 0;
+    if (n > 0) return (size_t)n;
+    const unsigned hc = std::thread::hardware_concurrency();
+    return hc ? hc : 1;
+}
+
+double percentile(std::vector<double> v, double q) {
+    std::sort(v.begin(), v.end());
+    const size_t i = (size_t)std::min<double>((double)(v.size() - 1), q * (double)v.size());
+    return v[i];
+}
+
+void runCase(const Topology& t, size_t n, const Options& opt) {
+    Bench b;
+
+    uint64_t a0 = g_allocs.load();
+    double t0 = nowMs();
+    t.build(b, n);
+    const double buildMs = nowMs() - t0;
+    const uint64_t buildAllocs = g_allocs.load() - a0;
+
+    t0 = nowMs();
+    if (engine_graph_run(b.g) != 0) Bench::fail("first run");
+    const double firstMs = nowMs() - t0;
+
+    std::vector<double> runs;
+    uint64_t allocs = 0, bytes = 0;
+    const double start = nowMs();
+    while (runs.size() < 3 || (runs.size() < opt.maxRuns && nowMs() - start < opt.minTimeMs)) {
+        b.touch(runs.size() + 1);
+        a0 = g_allocs.load();
+        const uint64_t b0 = g_allocBytes.load();
+        t0 = nowMs();
+        if (engine_graph_run(b.g) != 0) Bench::fail("run");
+        runs.push_back(nowMs() - t0);
+        allocs += g_allocs.load() - a0;
+        bytes += g_allocBytes.load() - b0;
+    }
+
+    rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+    const double p50 = percentile(runs, 0.50);
+    const double nRuns = (double)runs.size();
+    std::printf("{\"bench\":\"%s\",\"nodes\":%zu,\"edges\":%zu,\"build_ms\":%.3f,\"first_run_ms\":%.3f,"
+                "\"run_ms\":{\"min\":%.3f,\"p50\":%.3f,\"p95\":%.3f},\"runs\":%zu,\"nodes_per_sec\":%.0f,"
+                "\"peak_rss_kb\":%ld,\"build_allocs\":%llu,\"allocs_per_run\":%.1f,\"alloc_bytes_per_run\":%.0f,"
+                "\"threads\":%zu,\"catalog\":\"%s\"}\n",
+                t.name, b.nodes(), b.edges, buildMs, firstMs,
+                percentile(runs, 0.0), p50, percentile(runs, 0.95), runs.size(),
+                p50 > 0 ? (double)b.nodes() / (p50 / 1000.0) : 0.0,
+                ru.ru_maxrss, (unsigned long long)buildAllocs, (double)allocs / nRuns, (double)bytes / nRuns,
+                engineThreads(), engine_get_catalog_version());
+    std::fflush(stdout);
+}
+
+std::vector<std::string> splitList(const char* s) {
+    std::vector<std::string> out;
+    std::string cur;
+    for (const char* p = s; ; ++p) {
+        if (*p == ',' || *p == '\0') {
+            if (!cur.empty()) out.push_back(cur);
+            cur.clear();
+            if (*p == '\0') break;
+        } else {
+            cur += *p;
+        }
+    }
+    return out;
+}
+
+void usage() {
+    std::fprintf(stderr,
+        "usage: engine_bench [--topology a,b,..] [--sizes n1,n2,..] [--min-time SEC]\n"
+        "                    [--max-runs N] [--no-fork] [--list]\n"
+        "topologies: chain fanout diamond tree layered concat (default: all)\n"
+        "sizes: default 10,100,1000,10000,100000,1000000 (10M works, needs several GB)\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!std::strcmp(a, "--list")) {
+            for (const Topology& t : kTopologies) std::printf("%s\n", t.name);
+            return 0;
+        } else if (!std::strcmp(a, "--no-fork")) {
+            opt.fork = false;
+        } else if (!std::strcmp(a, "--topology") && v) {
+            opt.topologies = splitList(v); ++i;
+        } else if (!std::strcmp(a, "--sizes") && v) {
+            opt.sizes.clear();
+            for (const std::string& s : splitList(v)) opt.sizes.push_back((size_t)std::strtoull(s.c_str(), nullptr, 10));
+            ++i;
+        } else if (!std::strcmp(a, "--min-time") && v) {
+            opt.minTimeMs = std::strtod(v, nullptr) * 1000.0; ++i;
+        } else if (!std::strcmp(a, "--max-runs") && v) {
+            opt.maxRuns = (size_t)std::strtoull(v, nullptr, 10); ++i;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    std::vector<const Topology*> selected;
+    for (const Topology& t : kTopologies) {
+        if (opt.topologies.empty() ||
+            std::find(opt.topologies.begin(), opt.topologies.end(), t.name) != opt.topologies.end()) {
+            selected.push_back(&t);
+        }
+    }
+    if (selected.empty() || opt.sizes.empty()) {
+        usage();
+        return 1;
+    }
+
+    int failures = 0;
+    for (const Topology* t : selected) {
+        for (size_t n : opt.sizes) {
+            if (n == 0) continue;
+            if (!opt.fork) {
+                runCase(*t, n, opt);
+                continue;
+            }
+            // The engine's executor is created lazily on the first run, so the
+            // parent never owns threads and forking is safe.
+            const pid_t pid = fork();
+            if (pid < 0) {
+                std::perror("engine_bench: fork");
+                return 2;
+            }
+            if (pid == 0) {
+                runCase(*t, n, opt);
+                std::_Exit(0);
+            }
+            int status = 0;
+            waitpid(pid, &status, 0);
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                std::fprintf(stderr, "engine_bench: %s/%zu failed (status %d)\n", t->name, n, status);
+                ++failures;
+            }
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -1,18 +1,44 @@
 #include "engine_api.h"
+#include "engine_plugin.h"
 
 #include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <climits>
 #include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <list>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <variant>
 #include <vector>
 
+#include <dlfcn.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+#ifdef ENGINE_ALLOC_STATS
+#include <malloc.h>
+#include <new>
+#endif
+
+// LuaJIT (vendored in luajit/, linked statically)
+#include <lua.hpp>
+
 // Taskflow (header-only)
 #include <taskflow/taskflow.hpp>   // git submodule/clone; include path added in build
 
@@ -42,6 +68,35 @@ struct Node {
     std::unordered_map<std::string, Value> params;
     std::vector<Value> inputValues;
     std::vector<Value> outputValues;
+
+    // Change tracking since the last successful run.
+    // paramModified is indexed like type->params.
+    bool modified = true;  // a new node has never run
+    std::vector<bool> paramModified;
+    bool dirty = true;     // recomputed by the current run (modified or downstream of one)
+    uint32_t index = 0;    // dense index in the current CompiledGraph
+
+    // Adjacency: incoming edges in connect order (a later edge into the same
+    // input wins) and consumers, one entry per outgoing edge (parallel edges
+    // repeat). See linkNodes/unlinkInput.
+    struct Link { Node* src; int out; int in; };
+    std::vector<Link> inLinks;
+    std::vector<Node*> succ;
+
+    // Incremental topological order (see insertEdgeOrder): ord < succ->ord for every edge
+    int ord = 0;
+    uint32_t visit = 0;    // epoch of the last order search that reached this node
+    int outputPins = 0;    // Graph::outputs entries naming this node
+
+    int paramIndex(const std::string& key) const;
+    void markParamModified(int specIndex) {
+        modified = true;
+        if (specIndex >= 0 && specIndex < (int)paramModified.size()) paramModified[specIndex] = true;
+    }
+    void clearModified() {
+        modified = false;
+        std::fill(paramModified.begin(), paramModified.end(), false);
+    }
 };
 
 using ComputeFn = bool(*)(Node& n, std::string& err);
@@ -62,27 +117,79 @@ struct NodeType {
     std::string version;            // version info
     std::string description;        // description of the node
     ComputeFn compute;
+    // Plugin types only (compute == computePluginKernel)
+    eng_kernel_fn kernel = nullptr;
+    void* kernelUserData = nullptr;
+    double cost = 1.0;              // relative per-node cost estimate (1 = trivial arithmetic)
+    bool deterministic = true;      // same inputs and params always give the same outputs
+    int metricsSlot = -1;           // index of the per-type latency histogram (Registry::slotNames)
+};
+
+inline int Node::paramIndex(const std::string& key) const {
+    for (size_t i = 0; i < type->params.size(); ++i)
+        if (type->params[i].name == key) return (int)i;
+    return -1;
+}
+
+// Pre-resolved parameter slot (see engine_graph_param_handle).
+// slot points into node->params; unordered_map element addresses are stable,
+// so Graph::paramHandles keys handles by slot and resolving one is O(1).
+struct Graph;
+struct ParamHandle {
+    Graph* graph;
+    Node* node;
+    Value* slot;
+    int specIndex;
+    Type type;
 };
 
-struct Edge { int fromNode; int fromOut; int toNode; int toIn; };
 struct OutputPin { int node; int outIdx; };
 
 // JSON generation helpers
+
+// Appends str as JSON string contents: quotes, backslashes and every control
+// character are escaped, other bytes (UTF-8) are copied through in spans.
+static void appendJsonEscaped(std::string& out, const std::string& str) {
+    static const char hex[] = "0123456789abcdef";
+    size_t span = 0;
+    for (size_t i = 0; i < str.size(); ++i) {
+        const unsigned char c = (unsigned char)str[i];
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        out.append(str, span, i - span);
+        span = i + 1;
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                out += "\\u00";
+                out += hex[c >> 4];
+                out += hex[c & 15];
+        }
+    }
+    out.append(str, span, std::string::npos);
+}
+
 static std::string escapeJson(const std::string& str) {
     std::string escaped;
-    for (char c : str) {
-        if (c == '"') escaped += "\\\"";
-        else if (c == '\\') escaped += "\\\\";
-        else if (c == '\b') escaped += "\\b";
-        else if (c == '\f') escaped += "\\f";
-        else if (c == '\n') escaped += "\\n";
-        else if (c == '\r') escaped += "\\r";
-        else if (c == '\t') escaped += "\\t";
-        else escaped += c;
-    }
+    escaped.reserve(str.size());
+    appendJsonEscaped(escaped, str);
     return escaped;
 }
 
+// Shortest text that parses back to the same double. JSON has no inf/nan,
+// so those are written as null.
+static void appendJsonNumber(std::string& out, double v) {
+    if (!std::isfinite(v)) { out += "null"; return; }
+    char buf[32];
+    const auto r = std::to_chars(buf, buf + sizeof(buf), v);
+    out.append(buf, r.ptr);
+}
+
 static std::string typeToString(Type t) {
     switch (t) {
         case Type::Number: return "number";
@@ -111,6 +218,8 @@ static std::string nodeTypeToJson(const NodeType& nodeType) {
     json << "\"name\":\"" << escapeJson(nodeType.name) << "\",";
     json << "\"version\":\"" << escapeJson(nodeType.version) << "\",";
     json << "\"description\":\"" << escapeJson(nodeType.description) << "\",";
+    json << "\"cost\":" << nodeType.cost << ",";
+    json << "\"deterministic\":" << (nodeType.deterministic ? "true" : "false") << ",";
     
     // Inputs
     json << "\"inputs\":[";
@@ -224,364 +333,2135 @@ NodeType createClampNode() {
     };
 }
 
-struct Graph {
-    std::unordered_map<int, std::unique_ptr<Node>> nodes;
-    std::vector<Edge> edges;
-    std::vector<OutputPin> outputs;
-    std::unordered_map<std::string, NodeType> registry;
-    std::string lastError;
+// ========= LuaScript node =========
+//
+// Kernels written in Lua and run by the embedded LuaJIT. Each Taskflow worker
+// thread owns one lua_State, so calls take no locks. A source string is
+// compiled once per worker and the resulting function is kept in that state's
+// registry; the kLuaFunctionCache most recently used sources stay compiled and
+// older ones are released.
+//
+// Each call (including running the chunk that compiles a source) may execute
+// at most $TAZOR_LUA_INSTRUCTIONS VM instructions (default 10M), enforced by a
+// count hook, so a runaway script fails its node instead of holding an
+// executor worker forever. Hooks never fire inside JIT-compiled traces, so
+// with a budget the states run on the interpreter and `jit` is not exposed;
+// TAZOR_LUA_INSTRUCTIONS=0 removes the limit and turns the JIT back on.
+//
+// Only base/math/string/table/bit are opened (plus jit when unlimited): no io,
+// os, package or ffi.
+static const char* kLuaScriptDefault = "return function(a, b) return a + b end";
+static constexpr size_t kLuaFunctionCache = 256;
 
-    Graph() { registerBuiltins(); }
+static int luaInstructionBudget() {
+    static const int budget = [] {
+        const char* env = getenv("TAZOR_LUA_INSTRUCTIONS");
+        const long n = env ? strtol(env, nullptr, 10) : 10000000;
+        return (int)std::clamp(n, 0L, (long)INT_MAX);
+    }();
+    return budget;
+}
 
-    Node* getNode(int id) {
-        auto it = nodes.find(id);
-        return it == nodes.end() ? nullptr : it->second.get();
+// Fires once the budget is spent. It then re-arms itself for every
+// instruction, so a script cannot pcall its way past the limit.
+static void luaBudgetHook(lua_State* L, lua_Debug*) {
+    lua_sethook(L, luaBudgetHook, LUA_MASKCOUNT, 1);
+    luaL_error(L, "instruction limit exceeded (%d)", luaInstructionBudget());
+}
+
+// The error value on top of the stack as "LuaScript: <message>". error() may
+// raise any value, and lua_tostring returns NULL for tables, booleans etc.
+static std::string luaScriptError(lua_State* L) {
+    const char* msg = lua_tostring(L, -1);
+    if (msg) return std::string("LuaScript: ") + msg;
+    return std::string("LuaScript: error object is a ") + luaL_typename(L, -1) + " value";
+}
+
+struct LuaWorkerState {
+    lua_State* L = nullptr;
+    // source -> LUA_REGISTRYINDEX ref, most recently used first in `lru`
+    struct FnRef { int ref; std::list<std::string>::iterator pos; };
+    std::unordered_map<std::string, FnRef> fnRefs;
+    std::list<std::string> lru;
+
+    ~LuaWorkerState() { if (L) lua_close(L); }
+
+    bool init(std::string& err) {
+        if (L) return true;
+        L = luaL_newstate();
+        if (!L) { err = "LuaScript: cannot create Lua state"; return false; }
+        const lua_CFunction libs[] = {luaopen_base, luaopen_math, luaopen_string,
+                                      luaopen_table, luaopen_bit, luaopen_jit};
+        for (lua_CFunction open : libs) {
+            lua_pushcfunction(L, open);
+            lua_call(L, 0, 0);
+        }
+        for (const char* unsafe : {"dofile", "loadfile", "load", "loadstring"}) {
+            lua_pushnil(L);
+            lua_setglobal(L, unsafe);
+        }
+        if (luaInstructionBudget() > 0) {
+            luaJIT_setmode(L, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_OFF);
+            lua_pushnil(L);  // jit.on() would let compiled loops run past the hook
+            lua_setglobal(L, "jit");
+        }
+        return true;
     }
-    void setError(const std::string& e) { lastError = e; }
 
-    void registerBuiltins() {
-        registry["Number"] = NodeType{
-            "Number", {}, {Type::Number},
-            {ParamSpec{"value", Type::Number, Value::num(0.0), {}, "The numeric value"}},
-            "1.0.0", "A constant number node",
-            [](Node& n, std::string&)->bool {
-                double v = 0.0;
-                auto it = n.params.find("value");
-                if (it != n.params.end() && it->second.type == Type::Number) v = std::get<double>(it->second.data);
-                n.outputValues.assign(1, Value::num(v));
-                return true;
-            }
-        };
-        registry["String"] = NodeType{
-            "String", {}, {Type::String},
-            {ParamSpec{"text", Type::String, Value::str(""), {}, "The string value"}},
-            "1.0.0", "A constant string node",
-            [](Node& n, std::string&)->bool {
-                std::string s;
-                auto it = n.params.find("text");
-                if (it != n.params.end() && it->second.type == Type::String) s = std::get<std::string>(it->second.data);
-                n.outputValues.assign(1, Value::str(std::move(s)));
-                return true;
-            }
-        };
-        
-        // ========= Templated node families with concrete registrations =========
-        // These use template helpers to generate type-specific compute functions
-        // while exposing concrete names to the C API (no template syntax)
-        registry["AddNumber"] = createAddNode<Type::Number>();
-        registry["ClampNumber"] = createClampNode<Type::Number>();
-        
-        // Keep legacy "Add" for backward compatibility - maps to AddNumber
-        registry["Add"] = registry["AddNumber"];
-        
-        // ========= Other built-in nodes =========
-        registry["Multiply"] = NodeType{
-            "Multiply", {Type::Number, Type::Number}, {Type::Number},
-            {}, // no parameters
-            "1.0.0", "Multiplies two numbers together",
-            [](Node& n, std::string& err)->bool {
-                if (n.inputValues.size() != 2 ||
-                    n.inputValues[0].type != Type::Number ||
-                    n.inputValues[1].type != Type::Number) { err = "Multiply: invalid inputs"; return false; }
-                const double a = std::get<double>(n.inputValues[0].data);
-                const double b = std::get<double>(n.inputValues[1].data);
-                n.outputValues.assign(1, Value::num(a * b));
-                return true;
-            }
-        };
-        registry["ToString"] = NodeType{
-            "ToString", {Type::Number}, {Type::String},
-            {ParamSpec{"format", Type::String, Value::str("default"), {"default", "fixed", "scientific", "hex"}, "Number formatting style"}},
-            "1.0.0", "Converts a number to string with formatting options",
-            [](Node& n, std::string& err)->bool {
-                if (n.inputValues.size() != 1 || n.inputValues[0].type != Type::Number) { err = "ToString: invalid input"; return false; }
-                
-                // Get format parameter
-                std::string format = "default";
-                auto it = n.params.find("format");
-                if (it != n.params.end() && it->second.type == Type::String) {
-                    format = std::get<std::string>(it->second.data);
-                }
-                
-                double value = std::get<double>(n.inputValues[0].data);
-                std::ostringstream os;
-                
-                if (format == "fixed") {
-                    os << std::fixed << value;
-                } else if (format == "scientific") {
-                    os << std::scientific << value;
-                } else if (format == "hex") {
-                    os << std::hex << (int)value;
-                } else {
-                    os << value; // default
-                }
-                
-                n.outputValues.assign(1, Value::str(os.str()));
-                return true;
-            }
-        };
-        registry["Concat"] = NodeType{
-            "Concat", {Type::String, Type::String}, {Type::String},
-            {}, // no parameters
-            "1.0.0", "Concatenates two strings",
-            [](Node& n, std::string& err)->bool {
-                if (n.inputValues.size() != 2 ||
-                    n.inputValues[0].type != Type::String ||
-                    n.inputValues[1].type != Type::String) { err = "Concat: invalid inputs"; return false; }
-                const auto& a = std::get<std::string>(n.inputValues[0].data);
-                const auto& b = std::get<std::string>(n.inputValues[1].data);
-                n.outputValues.assign(1, Value::str(a + b));
-                return true;
-            }
-        };
-        registry["OutputNumber"] = NodeType{
-            "OutputNumber", {Type::Number}, {Type::Number},
-            {}, // no parameters
-            "1.0.0", "Outputs a number value",
-            [](Node& n, std::string& err)->bool {
-                if (n.inputValues.size() != 1 || n.inputValues[0].type != Type::Number) { err = "OutputNumber expects Number"; return false; }
-                n.outputValues.assign(1, n.inputValues[0]);
-                return true;
-            }
-        };
-        registry["OutputString"] = NodeType{
-            "OutputString", {Type::String}, {Type::String},
-            {}, // no parameters
-            "1.0.0", "Outputs a string value",
-            [](Node& n, std::string& err)->bool {
-                if (n.inputValues.size() != 1 || n.inputValues[0].type != Type::String) { err = "OutputString expects String"; return false; }
-                n.outputValues.assign(1, n.inputValues[0]);
-                return true;
-            }
-        };
+    // Protected call with a fresh instruction budget.
+    int call(int nargs) {
+        const int budget = luaInstructionBudget();
+        if (budget > 0) lua_sethook(L, luaBudgetHook, LUA_MASKCOUNT, budget);
+        const int rc = lua_pcall(L, nargs, 1, 0);
+        if (budget > 0) lua_sethook(L, nullptr, 0, 0);
+        return rc;
+    }
+
+    // Pushes the compiled function for `src`; compiles it on first use.
+    bool pushFunction(const std::string& src, std::string& err) {
+        auto it = fnRefs.find(src);
+        if (it != fnRefs.end()) {
+            lru.splice(lru.begin(), lru, it->second.pos);
+            lua_rawgeti(L, LUA_REGISTRYINDEX, it->second.ref);
+            return true;
+        }
+        if (luaL_loadbuffer(L, src.data(), src.size(), "=LuaScript") != 0 || call(0) != 0) {
+            err = luaScriptError(L);
+            lua_settop(L, 0);
+            return false;
+        }
+        if (!lua_isfunction(L, -1)) {
+            err = "LuaScript: source must return a function";
+            lua_settop(L, 0);
+            return false;
+        }
+        if (fnRefs.size() >= kLuaFunctionCache) {
+            auto victim = fnRefs.find(lru.back());
+            luaL_unref(L, LUA_REGISTRYINDEX, victim->second.ref);
+            fnRefs.erase(victim);
+            lru.pop_back();
+        }
+        lua_pushvalue(L, -1);
+        const int ref = luaL_ref(L, LUA_REGISTRYINDEX);
+        lru.push_front(src);
+        fnRefs.emplace(src, FnRef{ref, lru.begin()});
+        return true;
     }
 };
 
-// helper for type conversions
-static eng::Type fromC(eng_type_t t) {
-    switch (t) {
-        case ENG_TYPE_NUMBER: return eng::Type::Number;
-        case ENG_TYPE_STRING: return eng::Type::String;
-        case ENG_TYPE_BOOL:   return eng::Type::Bool;
+static bool computeLuaScript(Node& n, std::string& err) {
+    static thread_local LuaWorkerState lua;
+    if (n.inputValues.size() != 2 ||
+        n.inputValues[0].type != Type::Number ||
+        n.inputValues[1].type != Type::Number) { err = "LuaScript: invalid inputs"; return false; }
+    if (!lua.init(err)) return false;
+
+    auto it = n.params.find("source");
+    const bool custom = it != n.params.end() && it->second.type == Type::String;
+    static const std::string fallback = kLuaScriptDefault;
+    const std::string& src = custom ? std::get<std::string>(it->second.data) : fallback;
+
+    lua_State* L = lua.L;
+    if (!lua.pushFunction(src, err)) return false;
+    lua_pushnumber(L, std::get<double>(n.inputValues[0].data));
+    lua_pushnumber(L, std::get<double>(n.inputValues[1].data));
+    if (lua.call(2) != 0) {
+        err = luaScriptError(L);
+        lua_settop(L, 0);
+        return false;
     }
-    return eng::Type::Number;
-}
-static eng_type_t toC(eng::Type t) {
-    switch (t) {
-        case eng::Type::Number: return ENG_TYPE_NUMBER;
-        case eng::Type::String: return ENG_TYPE_STRING;
-        case eng::Type::Bool:   return ENG_TYPE_BOOL;
+    if (!lua_isnumber(L, -1)) {
+        err = "LuaScript: function must return a number";
+        lua_settop(L, 0);
+        return false;
     }
-    return ENG_TYPE_NUMBER;
+    const double r = lua_tonumber(L, -1);
+    lua_settop(L, 0);
+    n.outputValues.assign(1, Value::num(r));
+    return true;
+}
+
+// ========= built-in node types =========
+static void registerBuiltins(std::unordered_map<std::string, NodeType>& registry) {
+    registry["Number"] = NodeType{
+        "Number", {}, {Type::Number},
+        {ParamSpec{"value", Type::Number, Value::num(0.0), {}, "The numeric value"}},
+        "1.0.0", "A constant number node",
+        [](Node& n, std::string&)->bool {
+            double v = 0.0;
+            auto it = n.params.find("value");
+            if (it != n.params.end() && it->second.type == Type::Number) v = std::get<double>(it->second.data);
+            n.outputValues.assign(1, Value::num(v));
+            return true;
+        }
+    };
+    registry["String"] = NodeType{
+        "String", {}, {Type::String},
+        {ParamSpec{"text", Type::String, Value::str(""), {}, "The string value"}},
+        "1.0.0", "A constant string node",
+        [](Node& n, std::string&)->bool {
+            std::string s;
+            auto it = n.params.find("text");
+            if (it != n.params.end() && it->second.type == Type::String) s = std::get<std::string>(it->second.data);
+            n.outputValues.assign(1, Value::str(std::move(s)));
+            return true;
+        }
+    };
+    
+    // ========= Templated node families with concrete registrations =========
+    // These use template helpers to generate type-specific compute functions
+    // while exposing concrete names to the C API (no template syntax)
+    registry["AddNumber"] = createAddNode<Type::Number>();
+    registry["ClampNumber"] = createClampNode<Type::Number>();
+    
+    // Keep legacy "Add" for backward compatibility - maps to AddNumber
+    registry["Add"] = registry["AddNumber"];
+    
+    // ========= Other built-in nodes =========
+    registry["Multiply"] = NodeType{
+        "Multiply", {Type::Number, Type::Number}, {Type::Number},
+        {}, // no parameters
+        "1.0.0", "Multiplies two numbers together",
+        [](Node& n, std::string& err)->bool {
+            if (n.inputValues.size() != 2 ||
+                n.inputValues[0].type != Type::Number ||
+                n.inputValues[1].type != Type::Number) { err = "Multiply: invalid inputs"; return false; }
+            const double a = std::get<double>(n.inputValues[0].data);
+            const double b = std::get<double>(n.inputValues[1].data);
+            n.outputValues.assign(1, Value::num(a * b));
+            return true;
+        }
+    };
+    registry["ToString"] = NodeType{
+        "ToString", {Type::Number}, {Type::String},
+        {ParamSpec{"format", Type::String, Value::str("default"), {"default", "fixed", "scientific", "hex"}, "Number formatting style"}},
+        "1.0.0", "Converts a number to string with formatting options",
+        [](Node& n, std::string& err)->bool {
+            if (n.inputValues.size() != 1 || n.inputValues[0].type != Type::Number) { err = "ToString: invalid input"; return false; }
+            
+            // Get format parameter
+            std::string format = "default";
+            auto it = n.params.find("format");
+            if (it != n.params.end() && it->second.type == Type::String) {
+                format = std::get<std::string>(it->second.data);
+            }
+            
+            double value = std::get<double>(n.inputValues[0].data);
+            std::ostringstream os;
+            
+            if (format == "fixed") {
+                os << std::fixed << value;
+            } else if (format == "scientific") {
+                os << std::scientific << value;
+            } else if (format == "hex") {
+                os << std::hex << (int)value;
+            } else {
+                os << value; // default
+            }
+            
+            n.outputValues.assign(1, Value::str(os.str()));
+            return true;
+        }
+    };
+    registry["Concat"] = NodeType{
+        "Concat", {Type::String, Type::String}, {Type::String},
+        {}, // no parameters
+        "1.0.0", "Concatenates two strings",
+        [](Node& n, std::string& err)->bool {
+            if (n.inputValues.size() != 2 ||
+                n.inputValues[0].type != Type::String ||
+                n.inputValues[1].type != Type::String) { err = "Concat: invalid inputs"; return false; }
+            const auto& a = std::get<std::string>(n.inputValues[0].data);
+            const auto& b = std::get<std::string>(n.inputValues[1].data);
+            n.outputValues.assign(1, Value::str(a + b));
+            return true;
+        }
+    };
+    registry["OutputNumber"] = NodeType{
+        "OutputNumber", {Type::Number}, {Type::Number},
+        {}, // no parameters
+        "1.0.0", "Outputs a number value",
+        [](Node& n, std::string& err)->bool {
+            if (n.inputValues.size() != 1 || n.inputValues[0].type != Type::Number) { err = "OutputNumber expects Number"; return false; }
+            n.outputValues.assign(1, n.inputValues[0]);
+            return true;
+        }
+    };
+    registry["OutputString"] = NodeType{
+        "OutputString", {Type::String}, {Type::String},
+        {}, // no parameters
+        "1.0.0", "Outputs a string value",
+        [](Node& n, std::string& err)->bool {
+            if (n.inputValues.size() != 1 || n.inputValues[0].type != Type::String) { err = "OutputString expects String"; return false; }
+            n.outputValues.assign(1, n.inputValues[0]);
+            return true;
+        }
+    };
+    registry["LuaScript"] = NodeType{
+        "LuaScript", {Type::Number, Type::Number}, {Type::Number},
+        {ParamSpec{"source", Type::String, Value::str(kLuaScriptDefault), {}, "Lua chunk returning function(a, b) -> number"}},
+        "1.0.0", "Runs a user-supplied Lua function on the embedded LuaJIT",
+        computeLuaScript
+    };
+
+    // Relative cost estimates for the heavier built-ins; everything else is 1.
+    // Used by the server's admission control.
+    registry["ToString"].cost = 4.0;   // ostringstream formatting
+    registry["Concat"].cost = 2.0;     // string allocation
+    registry["LuaScript"].cost = 20.0; // Lua call + possible first-use compile
+
+    // User scripts can keep state between calls and use math.random
+    registry["LuaScript"].deterministic = false;
 }
 
-// Build inputs mapping and verify DAG (Kahn)
-static bool build_schedule(eng::Graph& g,
-                           std::unordered_map<int, std::vector<std::pair<int,int>>>& inputs,
-                           std::string& err_out) {
-    std::unordered_map<int, int> indeg;
-    std::unordered_map<int, std::vector<eng::Edge>> fanout;
-    indeg.reserve(g.nodes.size());
-
-    for (auto& kv : g.nodes) indeg[kv.first] = 0;
-    for (const auto& e : g.edges) {
-        fanout[e.fromNode].push_back(e);
-        indeg[e.toNode]++;
-        // Build inputs map by target slot
-        auto& vec = inputs[e.toNode];
-        if ((int)vec.size() <= e.toIn) vec.resize(e.toIn + 1, {-1,-1});
-        vec[e.toIn] = { e.fromNode, e.fromOut };
-    }
-
-    // Kahn
-    std::vector<int> q;
-    for (auto& kv : indeg) if (kv.second == 0) q.push_back(kv.first);
-    for (size_t i = 0; i < q.size(); ++i) {
-        int u = q[i];
-        for (auto& e : fanout[u]) if (--indeg[e.toNode] == 0) q.push_back(e.toNode);
-    }
-    // cycle?
-    for (auto& kv : indeg) if (kv.second != 0) {
-        err_out = "Cycle detected in graph";
+// ========= plugin kernels =========
+//
+// Node types registered through engine_plugin.h carry a C kernel instead of a
+// ComputeFn. computePluginKernel is installed as their ComputeFn and marshals
+// the node's values into flat eng_value_t arrays (thread-local scratch, no
+// per-call allocation) before calling the kernel.
+static eng_type_t toC(Type t);
+static Type fromC(eng_type_t t);
+
+static bool computePluginKernel(Node& n, std::string& err) {
+    const NodeType& t = *n.type;
+    static thread_local std::vector<eng_value_t> ins, params, outs;
+
+    auto toValue = [](const Value& v) {
+        eng_value_t c{toC(v.type), 0.0, 0, nullptr};
+        switch (v.type) {
+            case Type::Number: c.number = std::get<double>(v.data); break;
+            case Type::String: c.string = std::get<std::string>(v.data).c_str(); break;
+            case Type::Bool:   c.boolean = std::get<bool>(v.data) ? 1 : 0; break;
+        }
+        return c;
+    };
+
+    ins.clear();
+    for (const auto& v : n.inputValues) ins.push_back(toValue(v));
+    params.clear();
+    for (const auto& spec : t.params) {
+        auto it = n.params.find(spec.name);
+        const Value& v = (it != n.params.end() && it->second.type == spec.type) ? it->second : spec.defaultValue;
+        params.push_back(toValue(v));
+    }
+    outs.clear();
+    for (Type ot : t.outputs) outs.push_back(eng_value_t{toC(ot), 0.0, 0, ""});
+
+    eng_kernel_io_t io{ins.data(), (int)ins.size(),
+                       params.data(), (int)params.size(),
+                       outs.data(), (int)outs.size(),
+                       t.kernelUserData, nullptr};
+    if (t.kernel(&io) != 0) {
+        err = io.error ? io.error : "plugin kernel failed";
         return false;
     }
+
+    n.outputValues.resize(outs.size());
+    for (size_t i = 0; i < outs.size(); ++i) {
+        switch (t.outputs[i]) {
+            case Type::Number: n.outputValues[i] = Value::num(outs[i].number); break;
+            case Type::String: n.outputValues[i] = Value::str(outs[i].string ? outs[i].string : ""); break;
+            case Type::Bool:   n.outputValues[i] = Value::boolean(outs[i].boolean != 0); break;
+        }
+    }
     return true;
 }
 
-// Taskflow-powered execution.
-// Runs node tasks in parallel with precedence constraints.
-static bool runGraphTaskflow(eng::Graph& g) {
-    // Prepare default input/output buffers
-    for (auto& kv : g.nodes) {
-        auto* n = kv.second.get();
-        n->inputValues.assign(n->type->inputs.size(), eng::Value::num(0.0));
-        n->outputValues.clear();
+static bool validCType(eng_type_t t) {
+    return t == ENG_TYPE_NUMBER || t == ENG_TYPE_STRING || t == ENG_TYPE_BOOL;
+}
+
+static Value fromCValue(eng_type_t t, const eng_value_t& v) {
+    switch (t) {
+        case ENG_TYPE_STRING: return Value::str(v.string ? v.string : "");
+        case ENG_TYPE_BOOL:   return Value::boolean(v.boolean != 0);
+        default:              return Value::num(v.number);
     }
+}
 
-    // Build inputs mapping and verify DAG
-    std::unordered_map<int, std::vector<std::pair<int,int>>> inputs;
-    std::string schedule_err;
-    if (!build_schedule(g, inputs, schedule_err)) {
-        g.setError(schedule_err);
-        return false;
+// Translate a plugin descriptor into a NodeType; empty result on success.
+static std::string nodeTypeFromDesc(const eng_node_type_desc_t* d, NodeType& out) {
+    if (!d || !d->name || !*d->name) return "missing type name";
+    if (!d->kernel) return "missing kernel";
+    if (d->input_count < 0 || d->output_count < 0 || d->param_count < 0) return "negative count";
+    if ((d->input_count && !d->inputs) || (d->output_count && !d->outputs) || (d->param_count && !d->params))
+        return "null array with non-zero count";
+
+    out = NodeType{};
+    out.name = d->name;
+    out.version = d->version ? d->version : "";
+    out.description = d->description ? d->description : "";
+    out.deterministic = false;  // the v1 ABI cannot declare it
+    for (int i = 0; i < d->input_count; ++i) {
+        if (!validCType(d->inputs[i])) return "invalid input type";
+        out.inputs.push_back(fromC(d->inputs[i]));
+    }
+    for (int i = 0; i < d->output_count; ++i) {
+        if (!validCType(d->outputs[i])) return "invalid output type";
+        out.outputs.push_back(fromC(d->outputs[i]));
     }
+    for (int i = 0; i < d->param_count; ++i) {
+        const eng_param_desc_t& p = d->params[i];
+        if (!p.name || !*p.name) return "missing param name";
+        if (!validCType(p.type)) return "invalid param type";
+        ParamSpec spec{p.name, fromC(p.type), fromCValue(p.type, p.default_value), {}, p.description ? p.description : ""};
+        for (int k = 0; k < p.enum_count && p.enum_options; ++k)
+            if (p.enum_options[k]) spec.enumOptions.push_back(p.enum_options[k]);
+        out.params.push_back(std::move(spec));
+    }
+    out.compute = computePluginKernel;
+    out.kernel = d->kernel;
+    out.kernelUserData = d->user_data;
+    return {};
+}
 
-    tf::Taskflow tf;
-    tf::Executor ex;
-    std::unordered_map<int, tf::Task> tmap;
-    tmap.reserve(g.nodes.size());
-
-    std::mutex err_mtx;
-    bool failed = false;
-
-    // Create one task per node
-    for (auto& kv : g.nodes) {
-        const int id = kv.first;
-        auto task = tf.emplace([&, id]() {
-            if (failed) return; // cheap cancellation
-
-            eng::Node* n = g.getNode(id);
-
-            // Pull inputs from upstream outputs according to mapping
-            auto it = inputs.find(id);
-            if (it != inputs.end()) {
-                auto& map = it->second;
-                n->inputValues.resize(map.size());
-                for (size_t i = 0; i < map.size(); ++i) {
-                    auto [src, sout] = map[i];
-                    if (src < 0) continue;
-                    eng::Node* up = g.getNode(src);
-                    if (!up || sout < 0 || sout >= (int)up->outputValues.size()) {
-                        std::lock_guard<std::mutex> lk(err_mtx);
-                        if (!failed) { g.setError("Dangling edge or output index OOB"); failed = true; }
-                        return;
-                    }
-                    n->inputValues[i] = up->outputValues[sout];
-                }
-            }
+// ========= global registry + precomputed catalog =========
+//
+// One registry per process: the built-ins plus any plugin types. All JSON
+// served by the registry C API is rendered into an immutable Catalog whenever
+// the set of types changes. Superseded catalogs are kept alive so pointers
+// already handed out stay valid for the lifetime of the process.
+struct Catalog {
+    std::string listJson;                                  // ["Add",...]
+    std::unordered_map<std::string, std::string> specJson; // name -> spec
+    std::string catalogJson;                               // {"version":..,"types":{..}}
+    std::string version;                                   // hex content hash
+};
 
-            // Compute
-            std::string err;
-            if (!n->type->compute(*n, err)) {
-                std::lock_guard<std::mutex> lk(err_mtx);
-                if (!failed) { g.setError(n->type->name + " compute failed: " + err); failed = true; }
-            }
-        }).name(std::string("N") + std::to_string(id));
+struct Registry {
+    std::mutex mutex;  // guards types and catalogs
+    std::unordered_map<std::string, NodeType> types;
+    std::vector<std::unique_ptr<Catalog>> catalogs;
+    std::atomic<const Catalog*> current{nullptr};
+    std::unordered_set<void*> pluginHandles;
+    std::vector<std::string> slotNames;  // metricsSlot -> type name
 
-        tmap.emplace(id, std::move(task));
+    Registry() {
+        registerBuiltins(types);
+        for (auto& kv : types) assignSlot(kv.first, kv.second);
+        buildCatalog();
+        loadPluginsFromEnv();
     }
 
-    // Wire precedences (edges)
-    for (const auto& e : g.edges) {
-        auto itA = tmap.find(e.fromNode);
-        auto itB = tmap.find(e.toNode);
-        if (itA != tmap.end() && itB != tmap.end()) {
-            itA->second.precede(itB->second);
-        }
+    const Catalog& catalog() const { return *current.load(std::memory_order_acquire); }
+
+    // Node addresses in an unordered_map are stable, so the returned pointer
+    // outlives later registrations.
+    const NodeType* find(const std::string& name) {
+        std::lock_guard<std::mutex> lk(mutex);
+        auto it = types.find(name);
+        return it == types.end() ? nullptr : &it->second;
     }
 
-    std::cout << "Running the graph mfa neighbour!!" << std::endl;
-    ex.run(tf).wait();
+    // caller holds mutex (or is the constructor)
+    void assignSlot(const std::string& name, NodeType& t) {
+        t.metricsSlot = (int)slotNames.size();
+        slotNames.push_back(name);
+    }
 
-    if (failed) return false;
-    return true;
-}
+    std::vector<std::string> typeNamesBySlot() {
+        std::lock_guard<std::mutex> lk(mutex);
+        return slotNames;
+    }
 
-} // namespace eng
+    // caller holds mutex (or is the constructor)
+    void buildCatalog() {
+        std::vector<std::string> names;
+        names.reserve(types.size());
+        for (const auto& kv : types) names.push_back(kv.first);
+        std::sort(names.begin(), names.end());
 
-// ========= C API =========
-using Graph    = eng::Graph;
-using Node     = eng::Node;
-using NodeType = eng::NodeType;
-using Value    = eng::Value;
+        auto c = std::make_unique<Catalog>();
+        std::string list = "[";
+        std::string body = "{";
+        for (size_t i = 0; i < names.size(); ++i) {
+            const std::string& name = names[i];
+            std::string spec = nodeTypeToJson(types.at(name));
+            if (i > 0) { list += ","; body += ","; }
+            list += "\"" + escapeJson(name) + "\"";
+            body += "\"" + escapeJson(name) + "\":" + spec;
+            c->specJson.emplace(name, std::move(spec));
+        }
+        list += "]";
+        body += "}";
 
-static Graph* as(engine_graph_t g) { return reinterpret_cast<Graph*>(g); }
+        // FNV-1a 64 over the rendered specs: changes whenever any type changes
+        uint64_t h = 1469598103934665603ull;
+        for (unsigned char ch : body) { h ^= ch; h *= 1099511628211ull; }
+        char hex[17];
+        snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)h);
 
-extern "C" {
+        c->version = hex;
+        c->listJson = std::move(list);
+        c->catalogJson = "{\"version\":\"" + c->version + "\",\"types\":" + body + "}";
+        current.store(c.get(), std::memory_order_release);
+        catalogs.push_back(std::move(c));
+    }
 
-engine_graph_t engine_graph_create(void) {
-    try { return reinterpret_cast<engine_graph_t>(new Graph()); }
-    catch (...) { eng::c_error("engine_graph_create: OOM"); return nullptr; }
-}
+    static int hostRegister(void* ctx, const eng_node_type_desc_t* desc) {
+        auto* self = static_cast<Registry*>(ctx);
+        NodeType t;
+        std::string err = nodeTypeFromDesc(desc, t);
+        if (!err.empty()) { c_error("register_node_type: " + err); return 1; }
+        // called from loadPlugin with mutex held
+        if (self->types.count(t.name)) { c_error("register_node_type: duplicate type '" + t.name + "'"); return 2; }
+        std::string name = t.name;
+        auto it = self->types.emplace(std::move(name), std::move(t)).first;
+        self->assignSlot(it->first, it->second);
+        return 0;
+    }
 
-void engine_graph_destroy(engine_graph_t g) { delete as(g); }
+    int loadPlugin(const char* path) {
+        std::lock_guard<std::mutex> lk(mutex);
+        void* h = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+        if (!h) { c_error(std::string("load_plugin: ") + dlerror()); return 2; }
+        if (pluginHandles.count(h)) { dlclose(h); return 0; }  // already registered
 
-int engine_graph_add_node_with_id(engine_graph_t g, int node_id, const char* type, const char* name) {
-    if (!g || !type) { eng::c_error("add_node: null args"); return 1; }
-    Graph* gr = as(g);
-    if (gr->nodes.count(node_id)) { eng::c_error("add_node: duplicate id"); return 2; }
-    auto it = gr->registry.find(type);
-    if (it == gr->registry.end()) {
-        eng::c_error(std::string("add_node: unknown type '") + type + "'");
-        return 3;
+        auto entry = reinterpret_cast<eng_plugin_register_fn>(dlsym(h, ENGINE_PLUGIN_ENTRY));
+        if (!entry) {
+            c_error(std::string("load_plugin: '") + path + "' does not export " ENGINE_PLUGIN_ENTRY);
+            dlclose(h);
+            return 3;
+        }
+        const eng_plugin_host_t host{ENGINE_PLUGIN_ABI_VERSION, this, &Registry::hostRegister};
+        const size_t before = types.size();
+        const int rc = entry(&host);
+        // Kernels may already be referenced by registered types: never dlclose from here on.
+        pluginHandles.insert(h);
+        if (types.size() != before) buildCatalog();
+        if (rc != 0) {
+            if (g_last_error.empty()) c_error("load_plugin: registration failed");
+            return 4;
+        }
+        return 0;
     }
-    auto n = std::make_unique<Node>();
-    n->id = node_id; n->type = &it->second; if (name) n->name = name;
-    n->inputValues.assign(n->type->inputs.size(), Value::num(0.0));
-    gr->nodes[node_id] = std::move(n);
-    return 0;
-}
 
-int engine_graph_set_param_number(engine_graph_t g, int node_id, const char* key, double value) {
-    if (!g || !key) { eng::c_error("set_param_number: null args"); return 1; }
-    Graph* gr = as(g);
-    Node* n = gr->getNode(node_id);
-    if (!n) { eng::c_error("set_param_number: unknown node"); return 2; }
-    n->params[key] = Value::num(value);
-    return 0;
-}
-int engine_graph_set_param_string(engine_graph_t g, int node_id, const char* key, const char* value) {
-    if (!g || !key || !value) { eng::c_error("set_param_string: null args"); return 1; }
-    Graph* gr = as(g);
-    Node* n = gr->getNode(node_id);
-    if (!n) { eng::c_error("set_param_string: unknown node"); return 2; }
-    n->params[key] = Value::str(value);
-    return 0;
+    void loadPluginsFromEnv() {
+        const char* env = getenv("TAZOR_PLUGINS");
+        if (!env) return;
+        std::stringstream ss(env);
+        std::string path;
+        while (std::getline(ss, path, ':')) {
+            if (path.empty()) continue;
+            if (loadPlugin(path.c_str()) != 0)
+                std::cerr << "[engine] TAZOR_PLUGINS: " << g_last_error << std::endl;
+        }
+    }
+};
+
+static Registry& globalRegistry() {
+    static Registry registry;  // thread-safe lazy init
+    return registry;
 }
-int engine_graph_set_param_bool(engine_graph_t g, int node_id, const char* key, int value) {
-    if (!g || !key) { eng::c_error("set_param_bool: null args"); return 1; }
-    Graph* gr = as(g);
-    Node* n = gr->getNode(node_id);
-    if (!n) { eng::c_error("set_param_bool: unknown node"); return 2; }
-    n->params[key] = Value::boolean(!!value);
-    return 0;
+
+// ========= executors =========
+
+static size_t engineThreadCount() {
+    const char* env = getenv("TAZOR_ENGINE_THREADS");
+    const long n = env ? strtol(env, nullptr, 10) : 0;
+    if (n > 0) return (size_t)n;
+    const unsigned hc = std::thread::hardware_concurrency();
+    return (size_t)(hc ? hc : 1);
 }
 
-int engine_graph_connect(engine_graph_t g, int from_node, int from_output_idx, int to_node, int to_input_idx) {
-    if (!g) { eng::c_error("connect: null graph"); return 1; }
-    Graph* gr = as(g);
-    Node* a = gr->getNode(from_node);
-    Node* b = gr->getNode(to_node);
-    if (!a || !b) { eng::c_error("connect: unknown node id"); return 2; }
-    if (from_output_idx < 0 || from_output_idx >= (int)a->type->outputs.size()) { eng::c_error("connect: from_out OOB"); return 3; }
-    if (to_input_idx   < 0 || to_input_idx   >= (int)b->type->inputs.size()) { eng::c_error("connect: to_in OOB"); return 4; }
-    auto outT = a->type->outputs[from_output_idx];
-    auto inT  = b->type->inputs[to_input_idx];
-    if (outT != inT) { eng::c_error("connect: socket type mismatch"); return 5; }
-    gr->edges.push_back({from_node, from_output_idx, to_node, to_input_idx});
-    return 0;
+// One executor (worker thread pool) for the whole process, shared by every
+// graph. Size with $TAZOR_ENGINE_THREADS; defaults to hardware concurrency.
+static tf::Executor& sharedExecutor() {
+    static tf::Executor ex(engineThreadCount());
+    return ex;
 }
 
-int engine_graph_add_output(engine_graph_t g, int node_id, int out_index) {
-    if (!g) { eng::c_error("add_output: null graph"); return 1; }
-    Graph* gr = as(g);
-    Node* n = gr->getNode(node_id);
-    if (!n) { eng::c_error("add_output: unknown node id"); return 2; }
-    if (out_index < 0 || out_index >= (int)n->type->outputs.size()) { eng::c_error("add_output: out_index OOB"); return 3; }
-    gr->outputs.push_back({node_id, out_index});
-    return 0;
+static int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
-int engine_graph_run(engine_graph_t g) {
-    if (!g) { eng::c_error("run: null graph"); return 1; }
-    Graph* gr = as(g);
-    if (!eng::runGraphTaskflow(*gr)) {
-        eng::c_error(gr->lastError.empty() ? "execution failed" : gr->lastError);
-        return 2;
-    }
+// ========= profiling =========
+//
+// Profiled runs go to a second executor carrying a Taskflow observer, so runs
+// on the shared executor pay nothing when profiling is off. Each compiled
+// graph registers one sample slot per task, keyed by the task's hash_value;
+// the observer stamps worker and entry/exit time into it. A task runs once
+// per run, so slots are written without further locking.
+struct NodeSample {
+    Node* node = nullptr;
+    int worker = -1;
+    int64_t entryNs = 0;
+    int64_t exitNs = 0;
+};
+
+class ProfileObserver : public tf::ObserverInterface {
+public:
+    void set_up(size_t) override {}
+    void on_entry(tf::WorkerView w, tf::TaskView t) override {
+        if (NodeSample* s = find(t.hash_value())) { s->worker = (int)w.id(); s->entryNs = nowNs(); }
+    }
+    void on_exit(tf::WorkerView, tf::TaskView t) override {
+        if (NodeSample* s = find(t.hash_value())) s->exitNs = nowNs();
+    }
+    void add(size_t hash, NodeSample* s) {
+        std::unique_lock<std::shared_mutex> lk(mutex_);
+        slots_[hash] = s;
+    }
+    void remove(size_t hash) {
+        std::unique_lock<std::shared_mutex> lk(mutex_);
+        slots_.erase(hash);
+    }
+
+private:
+    NodeSample* find(size_t hash) {
+        std::shared_lock<std::shared_mutex> lk(mutex_);
+        auto it = slots_.find(hash);
+        return it == slots_.end() ? nullptr : it->second;
+    }
+    std::shared_mutex mutex_;
+    std::unordered_map<size_t, NodeSample*> slots_;
+};
+
+struct Profiler {
+    tf::Executor executor{engineThreadCount()};
+    std::shared_ptr<ProfileObserver> observer = executor.make_observer<ProfileObserver>();
+};
+
+static Profiler& profiler() {
+    static Profiler p;  // created on the first profiled run
+    return p;
+}
+
+// ========= tracing =========
+//
+// Chrome trace-event export of every run (engine_set_trace_dir or
+// $TAZOR_TRACE_DIR). Traced runs go through the profiling executor for the
+// per-node slices; graphs additionally time their construction, scheduling
+// and output extraction phases.
+struct TraceConfig {
+    std::mutex mutex;
+    std::string dir;
+    std::atomic<bool> on{false};
+    uint64_t seq = 0;
+    TraceConfig() {
+        const char* env = getenv("TAZOR_TRACE_DIR");
+        if (env && *env) { dir = env; on = true; }
+    }
+};
+
+static TraceConfig& traceConfig() {
+    static TraceConfig c;
+    return c;
+}
+
+static bool tracingOn() { return traceConfig().on.load(std::memory_order_relaxed); }
+
+// Phase boundaries of the last traced run (steady clock, ns).
+struct RunTrace {
+    bool pending = false;  // not yet written
+    int64_t buildStart = 0, buildEnd = 0;
+    int64_t schedStart = 0, execStart = 0, execEnd = 0, extractEnd = 0;
+};
+
+// ========= metrics =========
+//
+// Always-on latency histograms per run phase and per node type, plus run
+// counters. Each thread records into its own shard without locks or atomic
+// read-modify-writes; readers merge all shards. Shards are never freed, so
+// samples from exited threads remain counted.
+//
+// Histogram buckets are log-linear (HDR-style): values below 16 ns get one
+// bucket each, above that every power of two is split into 16 buckets, so a
+// bucket's width is at most 1/16 of its value. Up to 2^40 ns (~18 min).
+struct LatencyHistogram {
+    static constexpr int kSubBits = 4;
+    static constexpr int kSub = 1 << kSubBits;
+    static constexpr int kMaxExp = 40;
+    static constexpr int kBuckets = kSub + (kMaxExp - kSubBits + 1) * kSub;
+
+    std::atomic<uint64_t> counts[kBuckets] = {};
+    std::atomic<uint64_t> total{0}, sumNs{0}, maxNs{0};
+
+    static int bucketOf(uint64_t ns) {
+        if (ns < (uint64_t)kSub) return (int)ns;
+        int e = 63 - __builtin_clzll(ns);
+        if (e > kMaxExp) return kBuckets - 1;
+        return kSub + (e - kSubBits) * kSub + (int)((ns >> (e - kSubBits)) - kSub);
+    }
+    // Exclusive upper bound of bucket b.
+    static uint64_t bucketEnd(int b) {
+        if (b < kSub) return (uint64_t)b + 1;
+        const int e = kSubBits + (b - kSub) / kSub;
+        return (uint64_t)(kSub + (b - kSub) % kSub + 1) << (e - kSubBits);
+    }
+
+    // Single writer (the owning thread): plain load + store is enough.
+    static void bump(std::atomic<uint64_t>& a, uint64_t d) {
+        a.store(a.load(std::memory_order_relaxed) + d, std::memory_order_relaxed);
+    }
+    void record(uint64_t ns) {
+        bump(counts[bucketOf(ns)], 1);
+        bump(total, 1);
+        bump(sumNs, ns);
+        if (ns > maxNs.load(std::memory_order_relaxed)) maxNs.store(ns, std::memory_order_relaxed);
+    }
+};
+
+// Merged view of one series.
+struct LatencySnapshot {
+    std::vector<uint64_t> counts = std::vector<uint64_t>(LatencyHistogram::kBuckets, 0);
+    uint64_t total = 0, sumNs = 0, maxNs = 0;
+
+    void add(const LatencyHistogram& h) {
+        for (int b = 0; b < LatencyHistogram::kBuckets; ++b) counts[b] += h.counts[b].load(std::memory_order_relaxed);
+        total += h.total.load(std::memory_order_relaxed);
+        sumNs += h.sumNs.load(std::memory_order_relaxed);
+        maxNs = std::max(maxNs, h.maxNs.load(std::memory_order_relaxed));
+    }
+    // Upper end of the bucket holding the q-quantile, capped at the maximum.
+    uint64_t quantileNs(double q) const {
+        if (!total) return 0;
+        const uint64_t rank = std::max<uint64_t>(1, (uint64_t)std::ceil(q * (double)total));
+        uint64_t seen = 0;
+        for (int b = 0; b < LatencyHistogram::kBuckets; ++b) {
+            seen += counts[b];
+            if (seen >= rank) return std::min(LatencyHistogram::bucketEnd(b) - 1, maxNs);
+        }
+        return maxNs;
+    }
+    // Samples <= ns (bucket granularity).
+    uint64_t countAtMost(uint64_t ns) const {
+        uint64_t c = 0;
+        for (int b = 0; b < LatencyHistogram::kBuckets && LatencyHistogram::bucketEnd(b) - 1 <= ns; ++b) c += counts[b];
+        return c;
+    }
+};
+
+enum RunPhase { kPhaseBuild, kPhaseSchedule, kPhaseExecute, kPhaseCount };
+static const char* const kPhaseNames[kPhaseCount] = {"build", "schedule", "execute"};
+
+struct MetricsShard {
+    static constexpr int kMaxTypes = 1024;  // per-type series beyond this are not recorded
+
+    LatencyHistogram phases[kPhaseCount];
+    std::atomic<LatencyHistogram*> types[kMaxTypes] = {};  // by NodeType::metricsSlot, created on first use
+    std::atomic<uint64_t> runs{0}, failures{0}, nodes{0}, outputBytes{0};
+
+    ~MetricsShard() { for (auto& t : types) delete t.load(); }
+
+    void recordNode(const NodeType* type, uint64_t ns) {
+        LatencyHistogram::bump(nodes, 1);
+        const int slot = type->metricsSlot;
+        if (slot < 0 || slot >= kMaxTypes) return;
+        LatencyHistogram* h = types[slot].load(std::memory_order_acquire);
+        if (!h) {
+            h = new LatencyHistogram();
+            types[slot].store(h, std::memory_order_release);
+        }
+        h->record(ns);
+    }
+};
+
+struct Metrics {
+    std::mutex mutex;  // guards shards
+    std::vector<std::unique_ptr<MetricsShard>> shards;
+
+    MetricsShard* newShard() {
+        std::lock_guard<std::mutex> lk(mutex);
+        shards.push_back(std::make_unique<MetricsShard>());
+        return shards.back().get();
+    }
+};
+
+static Metrics& metrics() {
+    static Metrics* m = new Metrics();  // never destroyed: worker threads may record during exit
+    return *m;
+}
+
+static MetricsShard& metricsShard() {
+    static thread_local MetricsShard* shard = metrics().newShard();
+    return *shard;
+}
+
+// ========= hardware counters =========
+//
+// Opt-in per graph (engine_graph_set_perf_counters). Every executor worker
+// opens one perf_event_open counter group for itself on first use; a node
+// task reads the group when it starts and ends and keeps the difference.
+// Counters the kernel refuses (containers, perf_event_paranoid, VMs without a
+// PMU) are left out and read as zero; runs are never failed because of them.
+enum PerfCounter { kPerfCycles, kPerfInstructions, kPerfLlcMisses, kPerfBranchMisses, kPerfContextSwitches, kPerfCount };
+static const char* const kPerfNames[kPerfCount] = {"cycles", "instructions", "llc_misses", "branch_misses", "context_switches"};
+
+struct PerfGroup {
+    int fds[kPerfCount];
+    int pos[kPerfCount];  // index in the group read, -1 if not opened
+    int leader = -1;
+    int count = 0;
+    bool userOnly = false;  // every member excludes kernel time
+
+    // Kernel-side counting needs perf_event_paranoid < 2. Every member of a
+    // group is opened with the same exclude flags, so ratios such as IPC stay
+    // consistent: counting kernel time is kept unless user-only opens more.
+    PerfGroup() {
+        if (open(false) < kPerfCount) {
+            const int withKernel = count;
+            closeAll();
+            if (open(true) < withKernel) {
+                closeAll();
+                open(false);
+            }
+        }
+    }
+    ~PerfGroup() { closeAll(); }
+    PerfGroup(const PerfGroup&) = delete;
+    PerfGroup& operator=(const PerfGroup&) = delete;
+
+    int open(bool excludeKernel) {
+        std::fill(fds, fds + kPerfCount, -1);
+        std::fill(pos, pos + kPerfCount, -1);
+        userOnly = excludeKernel;
+#ifdef __linux__
+        static const std::pair<uint32_t, uint64_t> events[kPerfCount] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+        };
+        for (int i = 0; i < kPerfCount; ++i) {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = events[i].first;
+            attr.config = events[i].second;
+            attr.read_format = PERF_FORMAT_GROUP;
+            attr.exclude_hv = 1;
+            attr.exclude_kernel = excludeKernel;
+            const int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+            if (fd < 0) continue;
+            if (leader < 0) leader = fd;
+            fds[i] = fd;
+            pos[i] = count++;
+        }
+#endif
+        return count;
+    }
+    void closeAll() {
+        for (int i = kPerfCount - 1; i >= 0; --i)  // members before the leader
+            if (fds[i] >= 0) close(fds[i]);
+        std::fill(fds, fds + kPerfCount, -1);
+        std::fill(pos, pos + kPerfCount, -1);
+        leader = -1;
+        count = 0;
+    }
+
+    unsigned available() const {
+        unsigned mask = 0;
+        for (int i = 0; i < kPerfCount; ++i) if (pos[i] >= 0) mask |= 1u << i;
+        if (mask && userOnly) mask |= ENG_PERF_USER_ONLY;
+        return mask;
+    }
+    // Current counter values of the calling thread; false if none are open.
+    bool read(uint64_t (&values)[kPerfCount]) const {
+        if (!count) return false;
+        uint64_t buf[1 + kPerfCount];  // PERF_FORMAT_GROUP: nr, then one value per member
+        if (::read(leader, buf, sizeof(buf)) < (ssize_t)((1 + count) * sizeof(uint64_t))) return false;
+        for (int i = 0; i < kPerfCount; ++i) values[i] = pos[i] >= 0 ? buf[1 + pos[i]] : 0;
+        return true;
+    }
+};
+
+static PerfGroup& threadPerfGroup() {
+    static thread_local PerfGroup group;
+    return group;
+}
+
+// Counters that can be opened in this process (probed once, on the caller).
+static unsigned perfAvailable() {
+    static const unsigned mask = PerfGroup().available();
+    return mask;
+}
+
+static void addPerf(engine_perf_sample_t& to, const engine_perf_sample_t& from) {
+    to.cycles += from.cycles;
+    to.instructions += from.instructions;
+    to.llc_misses += from.llc_misses;
+    to.branch_misses += from.branch_misses;
+    to.context_switches += from.context_switches;
+}
+
+// Adds the calling thread's counter deltas over its lifetime to *out.
+class PerfTaskScope {
+public:
+    explicit PerfTaskScope(engine_perf_sample_t* out) : out_(out) {
+        if (out_ && !threadPerfGroup().read(start_)) out_ = nullptr;
+    }
+    ~PerfTaskScope() {
+        uint64_t end[kPerfCount];
+        if (!out_ || !threadPerfGroup().read(end)) return;
+        out_->cycles += end[kPerfCycles] - start_[kPerfCycles];
+        out_->instructions += end[kPerfInstructions] - start_[kPerfInstructions];
+        out_->llc_misses += end[kPerfLlcMisses] - start_[kPerfLlcMisses];
+        out_->branch_misses += end[kPerfBranchMisses] - start_[kPerfBranchMisses];
+        out_->context_switches += end[kPerfContextSwitches] - start_[kPerfContextSwitches];
+    }
+private:
+    engine_perf_sample_t* out_;
+    uint64_t start_[kPerfCount];
+};
+
+// ========= allocation accounting =========
+//
+// Built with -DENGINE_ALLOC_STATS, the library replaces the global operator
+// new/delete with counting versions. Each thread carries the counters of the
+// graph phase it is working on (AllocScope); allocations made outside any
+// scope are not counted.
+enum class AllocPhase { Build, Schedule, Execute, Output, Count };
+
+#ifdef ENGINE_ALLOC_STATS
+struct AllocCounters {
+    std::atomic<uint64_t> allocs{0}, frees{0}, bytes{0};
+    std::atomic<int64_t> live{0}, peak{0};  // block bytes allocated minus freed
+
+    void onAlloc(size_t requested, size_t block) {
+        allocs.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add(requested, std::memory_order_relaxed);
+        const int64_t l = live.fetch_add((int64_t)block, std::memory_order_relaxed) + (int64_t)block;
+        int64_t p = peak.load(std::memory_order_relaxed);
+        while (l > p && !peak.compare_exchange_weak(p, l, std::memory_order_relaxed)) {}
+    }
+    void onFree(size_t block) {
+        frees.fetch_add(1, std::memory_order_relaxed);
+        live.fetch_sub((int64_t)block, std::memory_order_relaxed);
+    }
+    void reset() { allocs = 0; frees = 0; bytes = 0; live = 0; peak = 0; }
+    engine_alloc_phase_t snapshot() const {
+        return engine_alloc_phase_t{(size_t)allocs.load(), (size_t)frees.load(), (size_t)bytes.load(),
+                                    (size_t)std::max<int64_t>(0, peak.load())};
+    }
+};
+
+static thread_local AllocCounters* t_allocScope = nullptr;
+#endif
+
+// Where a node input comes from; src is null for an unconnected input.
+struct InputSlot {
+    Node* src;
+    int out;
+};
+
+// Schedule + Taskflow for one topology. Kept across runs and dropped only when
+// nodes or edges change; parameter writes leave it intact.
+// Nodes are numbered densely (Node::index) and adjacency is flat (CSR): the
+// consumers of node i are consumers[consumerStart[i] .. consumerStart[i+1]),
+// its input slots inputs[inputStart[i] .. inputStart[i+1]) (one per declared input).
+struct CompiledGraph {
+    std::vector<Node*> nodes;              // by index
+    std::vector<uint32_t> consumerStart;   // nodes.size() + 1
+    std::vector<uint32_t> consumers;       // one per edge
+    std::vector<uint32_t> inputStart;      // nodes.size() + 1
+    std::vector<InputSlot> inputs;
+    tf::Taskflow taskflow;
+    std::atomic<bool> failed{false};
+    std::mutex errMutex;
+
+    // Profiling: one slot per task, registered with the observer on first use
+    std::vector<std::pair<size_t, Node*>> tasks;  // by node index: task hash_value -> node
+    std::vector<NodeSample> samples;              // parallel to tasks
+
+    // Hardware counters: one slot per task while the graph counts them
+    std::vector<engine_perf_sample_t> perf;       // parallel to tasks
+
+    void registerSamples() {
+        if (!samples.empty() || tasks.empty()) return;
+        samples.resize(tasks.size());
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            samples[i].node = tasks[i].second;
+            profiler().observer->add(tasks[i].first, &samples[i]);
+        }
+    }
+    ~CompiledGraph() {
+        if (samples.empty()) return;
+        for (const auto& t : tasks) profiler().observer->remove(t.first);
+    }
+};
+
+struct Graph {
+    std::unordered_map<int, std::unique_ptr<Node>> nodes;
+    size_t edgeCount = 0;
+    std::vector<OutputPin> outputs;
+    std::vector<Node*> order;  // by Node::ord: a topological order at all times; null for removed nodes
+    size_t orderHoles = 0;
+    uint32_t visitEpoch = 0;
+    std::vector<Node*> orderStack, orderFwd, orderBack;  // insertEdgeOrder scratch
+    std::vector<int> orderSlots;
+    std::unordered_map<const Value*, std::unique_ptr<ParamHandle>> paramHandles;  // by slot; released with the graph
+    Registry& registry;  // process-wide, shared by all graphs
+    std::string lastError;
+    std::unique_ptr<CompiledGraph> compiled;  // null until the next run compiles it
+    std::string outputsJson;  // engine_graph_outputs_json buffer, reused across runs
+    bool profiling = false;   // see engine_graph_set_profiling
+    std::vector<engine_node_profile_t> profile;  // last profiled run
+    bool profileRetyped = false;  // a node was retyped since: its wall time is for the old type
+    std::string profileJson;
+    int perfMode = ENG_PERF_OFF;  // see engine_graph_set_perf_counters
+    bool perfValid = false;       // perfTotal/perfNodes describe the last run
+    engine_perf_sample_t perfTotal{};
+    std::vector<engine_perf_sample_t> perfNodes;
+    std::string perfJson;
+    int64_t editStart = 0, editEnd = 0;  // edits since the last run (tracing only)
+    int64_t buildNs = 0;                 // time inside edit calls since the last run (metrics)
+    bool edited = false;
+    RunTrace trace;
+    bool resultsValid = false;  // unmodified nodes hold their outputs from the last successful run
+#ifdef ENGINE_ALLOC_STATS
+    AllocCounters alloc[(int)AllocPhase::Count];
+    engine_alloc_phase_t lastBuild{};  // edits that preceded the last run
+    bool ranOnce = false;
+#endif
+
+    Graph() : registry(globalRegistry()) {}
+
+    Node* getNode(int id) {
+        auto it = nodes.find(id);
+        return it == nodes.end() ? nullptr : it->second.get();
+    }
+    void setError(const std::string& e) { lastError = e; }
+    // Topology edits drop the schedule but keep results: the edit marks the
+    // nodes it affects modified and the next run recomputes them and their
+    // downstream nodes only. The schedule itself is rebuilt in O(V + E) by the
+    // next run; a Taskflow dependency cannot be removed in place.
+    void invalidateSchedule() { compiled.reset(); }
+    void removeFromOrder(Node* n) {
+        order[n->ord] = nullptr;
+        if (++orderHoles * 2 <= order.size()) return;
+        size_t k = 0;
+        for (Node* v : order) if (v) { v->ord = (int)k; order[k++] = v; }
+        order.resize(k);
+        orderHoles = 0;
+    }
+    // An edit call that started at `start` has finished (see EditTimer).
+    void noteEdit(int64_t start) {
+        const int64_t now = nowNs();
+        buildNs += now - start;
+        edited = true;
+        if (!tracingOn()) return;
+        editEnd = now;
+        if (!editStart) editStart = start;
+    }
+    void noteExtract() {
+        if (trace.pending) trace.extractEnd = nowNs();
+    }
+};
+
+// Attributes the current thread's allocations to one phase of `g` for the
+// lifetime of the scope; a no-op unless built with ENGINE_ALLOC_STATS.
+class AllocScope {
+public:
+#ifdef ENGINE_ALLOC_STATS
+    AllocScope(Graph& g, AllocPhase phase) : prev_(t_allocScope) { t_allocScope = &g.alloc[(int)phase]; }
+    ~AllocScope() { t_allocScope = prev_; }
+private:
+    AllocCounters* prev_;
+#else
+    AllocScope(Graph&, AllocPhase) {}
+#endif
+};
+
+// Charges the enclosing edit call to g's build phase, so the build histogram
+// measures time spent editing, not the client's pauses between edits.
+class EditTimer {
+public:
+    explicit EditTimer(Graph& g) : g_(g), start_(nowNs()) {}
+    ~EditTimer() { g_.noteEdit(start_); }
+private:
+    Graph& g_;
+    int64_t start_;
+};
+
+// Starts a new accounting period at the beginning of a run: edits made since
+// the previous run become the reported build phase.
+static void beginAllocPeriod(Graph& g) {
+#ifdef ENGINE_ALLOC_STATS
+    g.lastBuild = g.alloc[(int)AllocPhase::Build].snapshot();
+    g.ranOnce = true;
+    for (auto& c : g.alloc) c.reset();
+#else
+    (void)g;
+#endif
+}
+
+// ========= topological order =========
+//
+// Graph::order is kept topological as edges are added (Pearce & Kelly, "A
+// dynamic topological sort algorithm for directed acyclic graphs"). An edge
+// a -> b that already agrees with the order costs O(1). Otherwise only the
+// nodes whose ord lies between b and a are searched: those reachable from b
+// (fwd) and those reaching a (back). The back set is then moved in front of
+// the fwd set, reusing their existing ord slots. Reaching a from b means the
+// edge would close a cycle.
+
+// Collects into `out` the nodes reachable from `start` (through succ, or
+// inLinks when backward) whose ord lies strictly between lo and hi. Returns false if
+// `stop` is reached.
+static bool searchOrder(Graph& g, Node* start, bool backward, int lo, int hi,
+                        const Node* stop, std::vector<Node*>& out) {
+    out.clear();
+    auto& stack = g.orderStack;
+    stack.assign(1, start);
+    start->visit = g.visitEpoch;
+    while (!stack.empty()) {
+        Node* v = stack.back();
+        stack.pop_back();
+        out.push_back(v);
+        auto reach = [&](Node* w) {
+            if (w == stop) return false;
+            if (w->visit == g.visitEpoch || w->ord <= lo || w->ord >= hi) return true;
+            w->visit = g.visitEpoch;
+            stack.push_back(w);
+            return true;
+        };
+        if (backward) {
+            for (const auto& l : v->inLinks) if (!reach(l.src)) return false;
+        } else {
+            for (Node* w : v->succ) if (!reach(w)) return false;
+        }
+    }
+    return true;
+}
+
+// Reorders so that an edge a -> b fits the order. Returns false and leaves
+// the order unchanged if the edge would create a cycle.
+static bool insertEdgeOrder(Graph& g, Node* a, Node* b) {
+    if (a == b) return false;
+    if (a->ord > b->ord) {
+        const int lo = b->ord, hi = a->ord;
+        ++g.visitEpoch;
+        if (!searchOrder(g, b, false, -1, hi, a, g.orderFwd)) return false;
+        searchOrder(g, a, true, lo, INT_MAX, nullptr, g.orderBack);
+
+        auto byOrd = [](const Node* x, const Node* y) { return x->ord < y->ord; };
+        std::sort(g.orderFwd.begin(), g.orderFwd.end(), byOrd);
+        std::sort(g.orderBack.begin(), g.orderBack.end(), byOrd);
+        auto& slots = g.orderSlots;
+        slots.clear();
+        for (const Node* v : g.orderBack) slots.push_back(v->ord);
+        for (const Node* v : g.orderFwd) slots.push_back(v->ord);
+        std::inplace_merge(slots.begin(), slots.begin() + g.orderBack.size(), slots.end());
+        size_t k = 0;
+        for (Node* v : g.orderBack) { v->ord = slots[k++]; g.order[v->ord] = v; }
+        for (Node* v : g.orderFwd) { v->ord = slots[k++]; g.order[v->ord] = v; }
+    }
+    return true;
+}
+
+// Adds the edge a.out -> b.in (already ordered by insertEdgeOrder).
+static void linkNodes(Graph& g, Node* a, int out, Node* b, int in) {
+    a->succ.push_back(b);
+    b->inLinks.push_back({a, out, in});
+    ++g.edgeCount;
+}
+
+// Drops one entry for b from a->succ (order among consumers does not matter).
+static void dropConsumer(Node* a, const Node* b) {
+    auto it = std::find(a->succ.begin(), a->succ.end(), b);
+    if (it == a->succ.end()) return;
+    *it = a->succ.back();
+    a->succ.pop_back();
+}
+
+// Removes b's k-th incoming edge. Removing edges never invalidates the order.
+static void unlinkInput(Graph& g, Node* b, size_t k) {
+    dropConsumer(b->inLinks[k].src, b);
+    b->inLinks.erase(b->inLinks.begin() + k);
+    --g.edgeCount;
+}
+
+// helper for type conversions
+static eng::Type fromC(eng_type_t t) {
+    switch (t) {
+        case ENG_TYPE_NUMBER: return eng::Type::Number;
+        case ENG_TYPE_STRING: return eng::Type::String;
+        case ENG_TYPE_BOOL:   return eng::Type::Bool;
+    }
+    return eng::Type::Number;
+}
+static eng_type_t toC(eng::Type t) {
+    switch (t) {
+        case eng::Type::Number: return ENG_TYPE_NUMBER;
+        case eng::Type::String: return ENG_TYPE_STRING;
+        case eng::Type::Bool:   return ENG_TYPE_BOOL;
+    }
+    return ENG_TYPE_NUMBER;
+}
+
+// Numbers the nodes in topological order (Graph::order, so no sort is needed)
+// and builds the flat adjacency and input-slot tables. O(V + E), no per-node
+// allocations.
+static bool build_schedule(eng::Graph& g, eng::CompiledGraph& cg, std::string& err_out) {
+    const size_t n = g.nodes.size();
+    cg.nodes.clear();
+    cg.nodes.reserve(n);
+    cg.inputStart.assign(n + 1, 0);
+    for (eng::Node* node : g.order) {
+        if (!node) continue;
+        node->index = (uint32_t)cg.nodes.size();
+        cg.nodes.push_back(node);
+        cg.inputStart[node->index + 1] = cg.inputStart[node->index] + (uint32_t)node->type->inputs.size();
+    }
+    cg.inputs.assign(cg.inputStart[n], eng::InputSlot{nullptr, 0});
+
+    // Fill input slots and count out-degrees (shifted by one for the prefix sum)
+    cg.consumerStart.assign(n + 1, 0);
+    for (const eng::Node* b : cg.nodes) {
+        const uint32_t arity = cg.inputStart[b->index + 1] - cg.inputStart[b->index];
+        for (const auto& l : b->inLinks) {
+            if (l.in < 0 || (uint32_t)l.in >= arity) {
+                err_out = "Dangling edge or output index OOB";
+                return false;
+            }
+            cg.inputs[cg.inputStart[b->index] + l.in] = {l.src, l.out};
+            cg.consumerStart[l.src->index + 1]++;
+        }
+    }
+    for (size_t i = 0; i < n; ++i) cg.consumerStart[i + 1] += cg.consumerStart[i];
+    cg.consumers.resize(g.edgeCount);
+    std::vector<uint32_t> fill(cg.consumerStart.begin(), cg.consumerStart.end() - 1);
+    for (const eng::Node* b : cg.nodes)
+        for (const auto& l : b->inLinks) cg.consumers[fill[l.src->index]++] = b->index;
+    return true;
+}
+
+// Builds the schedule and one Taskflow task per node for the current topology.
+static bool compileGraph(eng::Graph& g) {
+    auto c = std::make_unique<eng::CompiledGraph>();
+    eng::CompiledGraph* cg = c.get();
+
+    std::string schedule_err;
+    if (!build_schedule(g, *cg, schedule_err)) {
+        g.setError(schedule_err);
+        return false;
+    }
+
+    // One task per node, in index order
+    std::vector<tf::Task> tasks;
+    tasks.reserve(cg->nodes.size());
+    cg->tasks.reserve(cg->nodes.size());
+    for (eng::Node* n : cg->nodes) {
+        const uint32_t idx = n->index;
+        auto task = cg->taskflow.emplace([&g, cg, n, idx]() {
+            if (cg->failed.load(std::memory_order_relaxed)) return; // cheap cancellation
+            if (!n->dirty) return;  // outputs from the previous run are still current
+            AllocScope scope(g, AllocPhase::Execute);
+            PerfTaskScope perf(g.perfMode != ENG_PERF_OFF ? &cg->perf[idx] : nullptr);
+            const int64_t start = nowNs();
+
+            // Pull inputs from upstream outputs
+            const eng::InputSlot* in = cg->inputs.data() + cg->inputStart[idx];
+            const size_t arity = cg->inputStart[idx + 1] - cg->inputStart[idx];
+            for (size_t i = 0; i < arity; ++i) {
+                const eng::Node* up = in[i].src;
+                if (!up) continue;
+                if (in[i].out < 0 || in[i].out >= (int)up->outputValues.size()) {
+                    std::lock_guard<std::mutex> lk(cg->errMutex);
+                    if (!cg->failed) { g.setError("Dangling edge or output index OOB"); cg->failed = true; }
+                    return;
+                }
+                n->inputValues[i] = up->outputValues[in[i].out];
+            }
+
+            // Compute
+            std::string err;
+            if (!n->type->compute(*n, err)) {
+                std::lock_guard<std::mutex> lk(cg->errMutex);
+                if (!cg->failed) { g.setError(n->type->name + " compute failed: " + err); cg->failed = true; }
+            }
+            metricsShard().recordNode(n->type, (uint64_t)(nowNs() - start));
+        });
+
+        cg->tasks.emplace_back(task.hash_value(), n);
+        tasks.push_back(task);
+    }
+
+    // Wire precedences (edges)
+    for (uint32_t u = 0; u < cg->nodes.size(); ++u)
+        for (uint32_t k = cg->consumerStart[u]; k < cg->consumerStart[u + 1]; ++k)
+            tasks[u].precede(tasks[cg->consumers[k]]);
+
+    g.compiled = std::move(c);
+    return true;
+}
+
+// Marks the nodes the next run has to compute. After a successful run of the
+// same topology only modified nodes and everything downstream of them are
+// recomputed; all other nodes keep their outputs.
+static void markDirty(eng::Graph& g) {
+    const eng::CompiledGraph& cg = *g.compiled;
+    if (!g.resultsValid) {
+        for (eng::Node* n : cg.nodes) n->dirty = true;
+        return;
+    }
+    std::vector<uint32_t> work;
+    for (eng::Node* n : cg.nodes) {
+        n->dirty = n->modified;
+        if (n->dirty) work.push_back(n->index);
+    }
+    while (!work.empty()) {
+        const uint32_t u = work.back();
+        work.pop_back();
+        for (uint32_t k = cg.consumerStart[u]; k < cg.consumerStart[u + 1]; ++k) {
+            eng::Node* m = cg.nodes[cg.consumers[k]];
+            if (!m->dirty) { m->dirty = true; work.push_back(m->index); }
+        }
+    }
+}
+
+// Compiles if needed and prepares buffers for the nodes this run computes.
+static bool prepareRun(eng::Graph& g) {
+    if (!g.compiled && !compileGraph(g)) return false;
+    g.compiled->failed = false;
+
+    eng::CompiledGraph& cg = *g.compiled;
+    g.perfValid = false;
+    if (g.perfMode != ENG_PERF_OFF) {
+        cg.perf.assign(cg.tasks.size(), engine_perf_sample_t{});
+        for (size_t i = 0; i < cg.tasks.size(); ++i) cg.perf[i].node_id = cg.tasks[i].second->id;
+    } else {
+        cg.perf.clear();
+    }
+
+    // Prepare default input/output buffers
+    markDirty(g);
+    for (eng::Node* n : cg.nodes) {
+        if (!n->dirty) continue;
+        n->inputValues.assign(n->type->inputs.size(), eng::Value::num(0.0));
+        n->outputValues.clear();
+    }
+    return true;
+}
+
+// Sums the per-task counter slots of a counted run.
+static void collectPerf(eng::Graph& g) {
+    g.perfTotal = engine_perf_sample_t{};
+    g.perfTotal.node_id = -1;
+    g.perfNodes.clear();
+    g.perfJson.clear();
+    if (g.perfMode == ENG_PERF_OFF) return;
+    for (size_t i = 0; i < g.compiled->perf.size(); ++i) {
+        if (!g.compiled->tasks[i].second->dirty) continue;
+        eng::addPerf(g.perfTotal, g.compiled->perf[i]);
+        if (g.perfMode == ENG_PERF_NODES) g.perfNodes.push_back(g.compiled->perf[i]);
+    }
+    g.perfValid = true;
+}
+
+static bool finishRun(eng::Graph& g) {
+    collectPerf(g);
+    const bool ok = !g.compiled->failed;
+    g.resultsValid = ok;
+    if (!ok) return false;
+    for (auto& kv : g.nodes) kv.second->clearModified();
+    return true;
+}
+
+static size_t valueBytes(const std::vector<eng::Value>& values) {
+    size_t bytes = 0;
+    for (const auto& v : values) {
+        if (v.type == eng::Type::String) bytes += std::get<std::string>(v.data).size();
+        else bytes += v.type == eng::Type::Number ? sizeof(double) : 1;
+    }
+    return bytes;
+}
+
+// Turns the samples of a profiled run into g.profile / g.profileJson. A node
+// becomes ready when its last upstream node exits (sources: at run start);
+// queue time is the gap between ready and the observer's on_entry.
+static void collectProfile(eng::Graph& g, int64_t t0, int64_t t1) {
+    eng::CompiledGraph& cg = *g.compiled;
+    const auto us = [](int64_t ns) { return (double)ns / 1000.0; };
+    g.profile.reserve(cg.samples.size());
+    for (const auto& s : cg.samples) {
+        if (s.worker < 0) continue;  // cancelled before it was scheduled
+        int64_t ready = t0;
+        const uint32_t idx = s.node->index;
+        for (uint32_t k = cg.inputStart[idx]; k < cg.inputStart[idx + 1]; ++k)
+            if (const eng::Node* up = cg.inputs[k].src) ready = std::max(ready, cg.samples[up->index].exitNs);
+        engine_node_profile_t p{};
+        p.node_id = s.node->id;
+        p.type = s.node->type->name.c_str();
+        p.name = s.node->name.c_str();
+        p.worker = s.worker;
+        p.start_us = us(s.entryNs - t0);
+        p.wall_us = us(s.exitNs - s.entryNs);
+        p.queue_us = us(std::max<int64_t>(0, s.entryNs - ready));
+        p.input_bytes = valueBytes(s.node->inputValues);
+        p.output_bytes = valueBytes(s.node->outputValues);
+        p.computed = s.node->dirty ? 1 : 0;
+        g.profile.push_back(p);
+    }
+    std::sort(g.profile.begin(), g.profile.end(),
+              [](const engine_node_profile_t& a, const engine_node_profile_t& b) { return a.start_us < b.start_us; });
+
+    std::string& out = g.profileJson;
+    out = "{\"run_us\":";
+    appendJsonNumber(out, us(t1 - t0));
+    out += ",\"workers\":";
+    out += std::to_string(profiler().executor.num_workers());
+    out += ",\"nodes\":[";
+    for (size_t i = 0; i < g.profile.size(); ++i) {
+        const auto& p = g.profile[i];
+        if (i > 0) out += ',';
+        out += "{\"id\":" + std::to_string(p.node_id) + ",\"type\":\"";
+        appendJsonEscaped(out, p.type);
+        out += "\",\"name\":\"";
+        appendJsonEscaped(out, p.name);
+        out += "\",\"worker\":" + std::to_string(p.worker) + ",\"start_us\":";
+        appendJsonNumber(out, p.start_us);
+        out += ",\"wall_us\":";
+        appendJsonNumber(out, p.wall_us);
+        out += ",\"queue_us\":";
+        appendJsonNumber(out, p.queue_us);
+        out += ",\"input_bytes\":" + std::to_string(p.input_bytes);
+        out += ",\"output_bytes\":" + std::to_string(p.output_bytes);
+        out += p.computed ? ",\"computed\":true}" : ",\"computed\":false}";
+    }
+    out += "]}";
+}
+
+// Writes g.trace as <dir>/trace-<pid>-<n>.json in Chrome trace-event format.
+// Lane 0 carries the run phases, lane w+1 the node tasks run by worker w.
+static void writeTrace(eng::Graph& g) {
+    eng::RunTrace& t = g.trace;
+    if (!t.pending) return;
+    t.pending = false;
+
+    const int64_t origin = t.buildStart;
+    const auto us = [origin](int64_t ns) { return (double)(ns - origin) / 1000.0; };
+    std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    const auto slice = [&out](const char* cat, const std::string& name, int tid, double ts, double dur,
+                              const std::string& args) {
+        out += "{\"ph\":\"X\",\"pid\":1,\"tid\":" + std::to_string(tid) + ",\"cat\":\"" + cat + "\",\"name\":\"";
+        appendJsonEscaped(out, name);
+        out += "\",\"ts\":";
+        appendJsonNumber(out, ts);
+        out += ",\"dur\":";
+        appendJsonNumber(out, dur);
+        if (!args.empty()) out += ",\"args\":" + args;
+        out += "},";
+    };
+
+    out += "{\"ph\":\"M\",\"pid\":1,\"name\":\"process_name\",\"args\":{\"name\":\"engine_graph_run\"}},";
+    out += "{\"ph\":\"M\",\"pid\":1,\"tid\":0,\"name\":\"thread_name\",\"args\":{\"name\":\"caller\"}},";
+    const size_t workers = profiler().executor.num_workers();
+    for (size_t w = 0; w < workers; ++w) {
+        out += "{\"ph\":\"M\",\"pid\":1,\"tid\":" + std::to_string(w + 1) +
+               ",\"name\":\"thread_name\",\"args\":{\"name\":\"worker " + std::to_string(w) + "\"}},";
+    }
+
+    const std::string counts = "{\"nodes\":" + std::to_string(g.nodes.size()) + ",\"edges\":" + std::to_string(g.edgeCount) + "}";
+    slice("phase", "construction", 0, 0.0, us(t.buildEnd), counts);
+    slice("phase", "scheduling", 0, us(t.schedStart), us(t.execStart) - us(t.schedStart), "");
+    slice("phase", "execution", 0, us(t.execStart), us(t.execEnd) - us(t.execStart), "");
+    slice("phase", "output extraction", 0, us(t.execEnd), us(t.extractEnd) - us(t.execEnd),
+          "{\"outputs\":" + std::to_string(g.outputs.size()) + "}");
+
+    const double execUs = us(t.execStart);
+    for (const auto& p : g.profile) {
+        std::string args = "{\"id\":" + std::to_string(p.node_id) + ",\"type\":\"";
+        appendJsonEscaped(args, p.type);
+        args += "\",\"name\":\"";
+        appendJsonEscaped(args, p.name);
+        args += "\",\"queue_us\":";
+        appendJsonNumber(args, p.queue_us);
+        args += ",\"input_bytes\":" + std::to_string(p.input_bytes) +
+                ",\"output_bytes\":" + std::to_string(p.output_bytes) +
+                (p.computed ? ",\"computed\":true}" : ",\"computed\":false}");
+        const std::string label = *p.name ? std::string(p.type) + " " + p.name : std::string(p.type);
+        slice(p.computed ? "node" : "node,skipped", label, p.worker + 1, execUs + p.start_us, p.wall_us, args);
+    }
+    out.back() = ']';
+    out += "}";
+
+    std::string path;
+    {
+        eng::TraceConfig& c = traceConfig();
+        std::lock_guard<std::mutex> lk(c.mutex);
+        if (c.dir.empty()) return;
+        path = c.dir + "/trace-" + std::to_string(getpid()) + "-" + std::to_string(++c.seq) + ".json";
+    }
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f || fwrite(out.data(), 1, out.size(), f) != out.size())
+        std::cerr << "[engine] trace: cannot write " << path << std::endl;
+    if (f) fclose(f);
+}
+
+// Feeds the metrics with one run of g: build (edit calls since the last run), schedule
+// and execute latencies (execEnd == 0: never executed), and its outcome.
+// Returns ok.
+static bool recordRun(eng::Graph& g, int64_t schedStart, int64_t schedEnd,
+                      int64_t execStart, int64_t execEnd, bool ok) {
+    using H = eng::LatencyHistogram;
+    eng::MetricsShard& m = eng::metricsShard();
+    if (g.edited) {
+        m.phases[eng::kPhaseBuild].record((uint64_t)std::max<int64_t>(0, g.buildNs));
+        g.buildNs = 0;
+        g.edited = false;
+    }
+    m.phases[eng::kPhaseSchedule].record((uint64_t)(schedEnd - schedStart));
+    if (execEnd) m.phases[eng::kPhaseExecute].record((uint64_t)(execEnd - execStart));
+    H::bump(m.runs, 1);
+    if (!ok) {
+        H::bump(m.failures, 1);
+        return false;
+    }
+    size_t bytes = 0;
+    for (const auto& pin : g.outputs) {
+        eng::Node* n = g.getNode(pin.node);
+        if (n && pin.outIdx >= 0 && pin.outIdx < (int)n->outputValues.size()) {
+            const auto& v = n->outputValues[pin.outIdx];
+            bytes += v.type == eng::Type::String ? std::get<std::string>(v.data).size() : sizeof(double);
+        }
+    }
+    H::bump(m.outputBytes, bytes);
+    return true;
+}
+
+// Taskflow-powered execution.
+// Runs node tasks in parallel with precedence constraints. The compiled
+// schedule is reused while the topology is unchanged, and clean nodes are
+// skipped (see markDirty).
+static bool runGraphTaskflow(eng::Graph& g) {
+    writeTrace(g);  // the previous traced run, now that its outputs have been read
+    const bool traced = tracingOn();
+    const int64_t s0 = nowNs();
+    g.profile.clear();
+    g.profileRetyped = false;
+    g.profileJson.clear();
+    beginAllocPeriod(g);
+    {
+        AllocScope scope(g, AllocPhase::Schedule);
+        if (!prepareRun(g)) return recordRun(g, s0, nowNs(), 0, 0, false);
+    }
+
+    AllocScope scope(g, AllocPhase::Execute);
+    if (!g.profiling && !traced) {
+        const int64_t t0 = nowNs();
+        sharedExecutor().run(g.compiled->taskflow).wait();
+        const int64_t t1 = nowNs();
+        return recordRun(g, s0, t0, t0, t1, finishRun(g));
+    }
+
+    eng::CompiledGraph& cg = *g.compiled;
+    cg.registerSamples();
+    for (auto& s : cg.samples) s.worker = -1;
+    const int64_t t0 = nowNs();
+    profiler().executor.run(cg.taskflow).wait();
+    const int64_t t1 = nowNs();
+    collectProfile(g, t0, t1);
+
+    if (traced) {
+        g.trace = eng::RunTrace{true, g.editStart ? g.editStart : s0, g.editStart ? g.editEnd : s0, s0, t0, t1, t1};
+        g.editStart = g.editEnd = 0;
+    }
+    return recordRun(g, s0, t0, t0, t1, finishRun(g));
+}
+
+// Runs independent graphs as one Taskflow: each graph's compiled taskflow is
+// composed in as a module, so the whole batch costs a single executor
+// submission and its nodes interleave across workers. Failures stay local to
+// their graph. ok[i] receives the outcome of graphs[i].
+static void runGraphsBatch(eng::Graph* const* graphs, int count, std::vector<bool>& ok) {
+    ok.assign(count, false);
+    std::vector<int64_t> sched(2 * (size_t)count);  // schedule start/end per graph
+    tf::Taskflow batch;
+    for (int i = 0; i < count; ++i) {
+        graphs[i]->profile.clear();  // batched runs are not profiled
+        graphs[i]->profileRetyped = false;
+        graphs[i]->profileJson.clear();
+        beginAllocPeriod(*graphs[i]);
+        AllocScope scope(*graphs[i], AllocPhase::Schedule);
+        sched[2 * i] = nowNs();
+        if (prepareRun(*graphs[i])) {
+            batch.composed_of(graphs[i]->compiled->taskflow);
+            ok[i] = true;
+        }
+        sched[2 * i + 1] = nowNs();
+    }
+
+    const int64_t t0 = nowNs();
+    sharedExecutor().run(batch).wait();
+    const int64_t t1 = nowNs();
+
+    for (int i = 0; i < count; ++i) {
+        if (ok[i]) ok[i] = recordRun(*graphs[i], sched[2 * i], sched[2 * i + 1], t0, t1, finishRun(*graphs[i]));
+        else recordRun(*graphs[i], sched[2 * i], sched[2 * i + 1], 0, 0, false);
+    }
+}
+
+// Renders {"outputs":[{"index":i,"type":..,"value":..},...]} for the output
+// pins into g.outputsJson in one pass.
+static const std::string& renderOutputsJson(eng::Graph& g) {
+    std::string& out = g.outputsJson;
+    out.clear();
+    out += "{\"outputs\":[";
+    char idx[16];
+    for (size_t i = 0; i < g.outputs.size(); ++i) {
+        if (i > 0) out += ',';
+        out += "{\"index\":";
+        out.append(idx, std::to_chars(idx, idx + sizeof(idx), i).ptr);
+
+        const auto& pin = g.outputs[i];
+        eng::Node* n = g.getNode(pin.node);
+        if (!n || pin.outIdx < 0 || pin.outIdx >= (int)n->outputValues.size()) {
+            out += ",\"type\":\"unknown\"}";
+            continue;
+        }
+        const auto& v = n->outputValues[pin.outIdx];
+        switch (v.type) {
+            case eng::Type::Number:
+                out += ",\"type\":\"number\",\"value\":";
+                appendJsonNumber(out, std::get<double>(v.data));
+                break;
+            case eng::Type::String:
+                out += ",\"type\":\"string\",\"value\":\"";
+                appendJsonEscaped(out, std::get<std::string>(v.data));
+                out += '"';
+                break;
+            case eng::Type::Bool:
+                out += ",\"type\":\"bool\",\"value\":";
+                out += std::get<bool>(v.data) ? "true" : "false";
+                break;
+        }
+        out += '}';
+    }
+    out += "]}";
+    return out;
+}
+
+static void appendPerfSample(std::string& out, const engine_perf_sample_t& p) {
+    out += "\"cycles\":" + std::to_string(p.cycles);
+    out += ",\"instructions\":" + std::to_string(p.instructions);
+    out += ",\"llc_misses\":" + std::to_string(p.llc_misses);
+    out += ",\"branch_misses\":" + std::to_string(p.branch_misses);
+    out += ",\"context_switches\":" + std::to_string(p.context_switches);
+}
+
+// {"available":["cycles",..],"user_only":bool,"total":{..},"nodes":[{"id":..,..},..]}
+static const std::string& renderPerfJson(Graph& g) {
+    std::string& out = g.perfJson;
+    if (!out.empty()) return out;
+    out = "{\"available\":[";
+    const unsigned mask = perfAvailable();
+    bool first = true;
+    for (int i = 0; i < kPerfCount; ++i) {
+        if (!(mask & (1u << i))) continue;
+        if (!first) out += ',';
+        first = false;
+        out += '"';
+        out += kPerfNames[i];
+        out += '"';
+    }
+    out += "],\"user_only\":";
+    out += (mask & ENG_PERF_USER_ONLY) ? "true" : "false";
+    out += ",\"total\":{";
+    appendPerfSample(out, g.perfTotal);
+    out += "},\"nodes\":[";
+    for (size_t i = 0; i < g.perfNodes.size(); ++i) {
+        if (i > 0) out += ',';
+        out += "{\"id\":" + std::to_string(g.perfNodes[i].node_id) + ',';
+        appendPerfSample(out, g.perfNodes[i]);
+        out += '}';
+    }
+    out += "]}";
+    return out;
+}
+
+// ========= metrics export =========
+
+static LatencySnapshot phaseSnapshot(int phase) {
+    LatencySnapshot snap;
+    std::lock_guard<std::mutex> lk(metrics().mutex);
+    for (const auto& shard : metrics().shards) snap.add(shard->phases[phase]);
+    return snap;
+}
+
+// Merged per-type series, one per registered type name (aliases like "Add"
+// are separate series); types that never ran are left out.
+static std::vector<std::pair<std::string, LatencySnapshot>> typeSnapshots() {
+    const std::vector<std::string> names = globalRegistry().typeNamesBySlot();
+    std::vector<std::pair<std::string, LatencySnapshot>> out;
+    std::lock_guard<std::mutex> lk(metrics().mutex);
+    for (size_t slot = 0; slot < names.size() && slot < (size_t)MetricsShard::kMaxTypes; ++slot) {
+        LatencySnapshot snap;
+        for (const auto& shard : metrics().shards)
+            if (const LatencyHistogram* h = shard->types[slot].load(std::memory_order_acquire)) snap.add(*h);
+        if (snap.total) out.emplace_back(names[slot], std::move(snap));
+    }
+    std::sort(out.begin(), out.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    return out;
+}
+
+static void summarize(const LatencySnapshot& s, engine_latency_summary_t& out) {
+    out.count = s.total;
+    out.sum_us = (double)s.sumNs / 1000.0;
+    out.p50_us = (double)s.quantileNs(0.50) / 1000.0;
+    out.p90_us = (double)s.quantileNs(0.90) / 1000.0;
+    out.p99_us = (double)s.quantileNs(0.99) / 1000.0;
+    out.p999_us = (double)s.quantileNs(0.999) / 1000.0;
+    out.max_us = (double)s.maxNs / 1000.0;
+}
+
+// Prometheus histogram buckets (seconds): 1-2.5-5 steps from 1us to 10s.
+static const double kPromBuckets[] = {
+    1e-6, 2.5e-6, 5e-6, 1e-5, 2.5e-5, 5e-5, 1e-4, 2.5e-4, 5e-4, 1e-3, 2.5e-3, 5e-3,
+    1e-2, 2.5e-2, 5e-2, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0,
+};
+
+static void appendPromHistogram(std::string& out, const char* name, const std::string& labels,
+                                const LatencySnapshot& s) {
+    char num[64];
+    for (double le : kPromBuckets) {
+        snprintf(num, sizeof(num), "%g", le);
+        out += std::string(name) + "_bucket{" + labels + ",le=\"" + num + "\"} " +
+               std::to_string(s.countAtMost((uint64_t)std::llround(le * 1e9))) + "\n";
+    }
+    out += std::string(name) + "_bucket{" + labels + ",le=\"+Inf\"} " + std::to_string(s.total) + "\n";
+    snprintf(num, sizeof(num), "%.9g", (double)s.sumNs / 1e9);
+    out += std::string(name) + "_sum{" + labels + "} " + num + "\n";
+    out += std::string(name) + "_count{" + labels + "} " + std::to_string(s.total) + "\n";
+}
+
+static engine_metrics_counters_t counterTotals() {
+    engine_metrics_counters_t c{};
+    std::lock_guard<std::mutex> lk(metrics().mutex);
+    for (const auto& shard : metrics().shards) {
+        c.runs += shard->runs.load(std::memory_order_relaxed);
+        c.run_failures += shard->failures.load(std::memory_order_relaxed);
+        c.nodes_executed += shard->nodes.load(std::memory_order_relaxed);
+        c.output_bytes += shard->outputBytes.load(std::memory_order_relaxed);
+    }
+    return c;
+}
+
+static std::string renderPrometheus() {
+    const engine_metrics_counters_t c = counterTotals();
+    std::string out;
+    out += "# HELP tazor_engine_runs_total Graph runs (batched graphs count individually).\n"
+           "# TYPE tazor_engine_runs_total counter\n"
+           "tazor_engine_runs_total " + std::to_string(c.runs) + "\n";
+    out += "# HELP tazor_engine_run_failures_total Graph runs that failed.\n"
+           "# TYPE tazor_engine_run_failures_total counter\n"
+           "tazor_engine_run_failures_total " + std::to_string(c.run_failures) + "\n";
+    out += "# HELP tazor_engine_nodes_executed_total Node computations (clean nodes skipped by incremental runs excluded).\n"
+           "# TYPE tazor_engine_nodes_executed_total counter\n"
+           "tazor_engine_nodes_executed_total " + std::to_string(c.nodes_executed) + "\n";
+    out += "# HELP tazor_engine_output_bytes_total Payload bytes of graph outputs of successful runs.\n"
+           "# TYPE tazor_engine_output_bytes_total counter\n"
+           "tazor_engine_output_bytes_total " + std::to_string(c.output_bytes) + "\n";
+
+    out += "# HELP tazor_engine_phase_seconds Run phase latency: build (first edit to run), schedule, execute.\n"
+           "# TYPE tazor_engine_phase_seconds histogram\n";
+    for (int p = 0; p < kPhaseCount; ++p)
+        appendPromHistogram(out, "tazor_engine_phase_seconds", std::string("phase=\"") + kPhaseNames[p] + "\"", phaseSnapshot(p));
+
+    out += "# HELP tazor_engine_node_seconds Node compute latency by node type.\n"
+           "# TYPE tazor_engine_node_seconds histogram\n";
+    for (const auto& [name, snap] : typeSnapshots()) {
+        std::string label = "type=\"";
+        for (char ch : name) {
+            if (ch == '\\' || ch == '"') label += '\\';
+            if (ch == '\n') { label += "\\n"; continue; }
+            label += ch;
+        }
+        label += '"';
+        appendPromHistogram(out, "tazor_engine_node_seconds", label, snap);
+    }
+    return out;
+}
+
+// ========= analysis =========
+//
+// Level structure and critical path of the current topology. Node costs are
+// the wall times of the last run when it was profiled and computed every
+// node, otherwise the per-type catalog estimates.
+static void analyzeGraph(Graph& g, engine_graph_analysis_t& out) {
+    out = engine_graph_analysis_t{};
+    const size_t n = g.nodes.size();
+    std::unordered_map<int, size_t> index;
+    std::vector<const Node*> byIndex;
+    index.reserve(n);
+    byIndex.reserve(n);
+    for (const Node* node : g.order) {  // topological, so one forward pass suffices
+        if (!node) continue;
+        index.emplace(node->id, byIndex.size());
+        byIndex.push_back(node);
+    }
+
+    bool measured = n > 0 && g.profile.size() == n && !g.profileRetyped;
+    std::vector<double> cost(n);
+    if (measured) {
+        for (const auto& p : g.profile) {
+            auto it = index.find(p.node_id);
+            if (it == index.end() || !p.computed) { measured = false; break; }
+            cost[it->second] = p.wall_us;
+        }
+    }
+    if (!measured)
+        for (size_t i = 0; i < n; ++i) cost[i] = byIndex[i]->type->cost;
+
+    // level = longest path in nodes, finish = cost-weighted
+    std::vector<int> level(n, 1);
+    std::vector<double> finish(n, 0.0);
+    for (size_t v = 0; v < n; ++v) {
+        for (const auto& l : byIndex[v]->inLinks) {
+            const size_t u = index.at(l.src->id);
+            level[v] = std::max(level[v], level[u] + 1);
+            finish[v] = std::max(finish[v], finish[u]);
+        }
+        finish[v] += cost[v];
+    }
+
+    std::vector<int> width;
+    for (size_t i = 0; i < n; ++i) {
+        if ((int)width.size() < level[i]) width.resize(level[i], 0);
+        width[level[i] - 1]++;
+        out.work += cost[i];
+        out.critical_path = std::max(out.critical_path, finish[i]);
+    }
+    out.nodes = (int)n;
+    out.edges = (int)g.edgeCount;
+    out.depth = (int)width.size();
+    for (int w : width) out.max_width = std::max(out.max_width, w);
+    out.avg_width = out.depth ? (double)n / out.depth : 0.0;
+    out.parallelism = out.critical_path > 0 ? out.work / out.critical_path : 0.0;
+    out.measured = measured ? 1 : 0;
+}
+
+} // namespace eng
+
+// ========= C API =========
+using Graph    = eng::Graph;
+using Node     = eng::Node;
+using NodeType = eng::NodeType;
+using Value    = eng::Value;
+
+static Graph* as(engine_graph_t g) { return reinterpret_cast<Graph*>(g); }
+
+extern "C" {
+
+engine_graph_t engine_graph_create(void) {
+    try { return reinterpret_cast<engine_graph_t>(new Graph()); }
+    catch (...) { eng::c_error("engine_graph_create: OOM"); return nullptr; }
+}
+
+void engine_graph_destroy(engine_graph_t g) {
+    if (!g) return;
+    eng::writeTrace(*as(g));
+    delete as(g);
+}
+
+int engine_graph_add_node_with_id(engine_graph_t g, int node_id, const char* type, const char* name) {
+    if (!g || !type) { eng::c_error("add_node: null args"); return 1; }
+    Graph* gr = as(g);
+    eng::AllocScope scope(*gr, eng::AllocPhase::Build);
+    eng::EditTimer edit(*gr);
+    if (gr->nodes.count(node_id)) { eng::c_error("add_node: duplicate id"); return 2; }
+    const NodeType* nt = gr->registry.find(type);
+    if (!nt) {
+        eng::c_error(std::string("add_node: unknown type '") + type + "'");
+        return 3;
+    }
+    auto n = std::make_unique<Node>();
+    n->id = node_id; n->type = nt; if (name) n->name = name;
+    n->inputValues.assign(n->type->inputs.size(), Value::num(0.0));
+    n->paramModified.assign(n->type->params.size(), false);
+    n->ord = (int)gr->order.size();
+    gr->order.push_back(n.get());
+    gr->nodes[node_id] = std::move(n);
+    gr->invalidateSchedule();
+    return 0;
+}
+
+int engine_graph_set_param_number(engine_graph_t g, int node_id, const char* key, double value) {
+    if (!g || !key) { eng::c_error("set_param_number: null args"); return 1; }
+    Graph* gr = as(g);
+    eng::AllocScope scope(*gr, eng::AllocPhase::Build);
+    eng::EditTimer edit(*gr);
+    Node* n = gr->getNode(node_id);
+    if (!n) { eng::c_error("set_param_number: unknown node"); return 2; }
+    n->params[key] = Value::num(value);
+    n->markParamModified(n->paramIndex(key));
+    return 0;
+}
+int engine_graph_set_param_string(engine_graph_t g, int node_id, const char* key, const char* value) {
+    if (!g || !key || !value) { eng::c_error("set_param_string: null args"); return 1; }
+    Graph* gr = as(g);
+    eng::AllocScope scope(*gr, eng::AllocPhase::Build);
+    eng::EditTimer edit(*gr);
+    Node* n = gr->getNode(node_id);
+    if (!n) { eng::c_error("set_param_string: unknown node"); return 2; }
+    n->params[key] = Value::str(value);
+    n->markParamModified(n->paramIndex(key));
+    return 0;
+}
+int engine_graph_set_param_bool(engine_graph_t g, int node_id, const char* key, int value) {
+    if (!g || !key) { eng::c_error("set_param_bool: null args"); return 1; }
+    Graph* gr = as(g);
+    eng::AllocScope scope(*gr, eng::AllocPhase::Build);
+    eng::EditTimer edit(*gr);
+    Node* n = gr->getNode(node_id);
+    if (!n) { eng::c_error("set_param_bool: unknown node"); return 2; }
+    n->params[key] = Value::boolean(!!value);
+    n->markParamModified(n->paramIndex(key));
+    return 0;
+}
+
+engine_param_t engine_graph_param_handle(engine_graph_t g, int node_id, const char* key) {
+    if (!g || !key) { eng::c_error("param_handle: null args"); return nullptr; }
+    Graph* gr = as(g);
+    eng::AllocScope scope(*gr, eng::AllocPhase::Build);
+    Node* n = gr->getNode(node_id);
+    if (!n) { eng::c_error("param_handle: unknown node"); return nullptr; }
+    const int idx = n->paramIndex(key);
+    if (idx < 0) {
+        eng::c_error(std::string("param_handle: '") + n->type->name + "' has no param '" + key + "'");
+        return nullptr;
+    }
+    const auto& spec = n->type->params[idx];
+    auto it = n->params.find(spec.name);
+    if (it == n->params.end()) it = n->params.emplace(spec.name, spec.defaultValue).first;
+    auto& h = gr->paramHandles[&it->second];  // one handle per slot
+    if (!h) h = std::make_unique<eng::ParamHandle>(eng::ParamHandle{gr, n, &it->second, idx, spec.type});
+    return h.get();
+}
+
+static eng::ParamHandle* asHandle(engine_param_t p) { return reinterpret_cast<eng::ParamHandle*>(p); }
+
+int engine_param_set_number(engine_param_t p, double value) {
+    eng::ParamHandle* h = asHandle(p);
+    if (!h) { eng::c_error("param_set_number: null handle"); return 1; }
+    eng::EditTimer edit(*h->graph);
+    if (h->type != eng::Type::Number) { eng::c_error("param_set_number: param is not a number"); return 2; }
+    h->slot->type = eng::Type::Number;
+    h->slot->data = value;
+    h->node->markParamModified(h->specIndex);
+    return 0;
+}
+int engine_param_set_string(engine_param_t p, const char* value) {
+    eng::ParamHandle* h = asHandle(p);
+    if (!h || !value) { eng::c_error("param_set_string: null args"); return 1; }
+    eng::EditTimer edit(*h->graph);
+    if (h->type != eng::Type::String) { eng::c_error("param_set_string: param is not a string"); return 2; }
+    h->slot->type = eng::Type::String;
+    h->slot->data = std::string(value);
+    h->node->markParamModified(h->specIndex);
+    return 0;
+}
+int engine_param_set_bool(engine_param_t p, int value) {
+    eng::ParamHandle* h = asHandle(p);
+    if (!h) { eng::c_error("param_set_bool: null handle"); return 1; }
+    eng::EditTimer edit(*h->graph);
+    if (h->type != eng::Type::Bool) { eng::c_error("param_set_bool: param is not a bool"); return 2; }
+    h->slot->type = eng::Type::Bool;
+    h->slot->data = !!value;
+    h->node->markParamModified(h->specIndex);
+    return 0;
+}
+
+int engine_param_modified(engine_param_t p) {
+    eng::ParamHandle* h = asHandle(p);
+    if (!h) { eng::c_error("param_modified: null handle"); return -1; }
+    return h->node->paramModified[h->specIndex] ? 1 : 0;
+}
+int engine_graph_param_modified(engine_graph_t g, int node_id, const char* key) {
+    if (!g || !key) { eng::c_error("param_modified: null args"); return -1; }
+    Node* n = as(g)->getNode(node_id);
+    if (!n) { eng::c_error("param_modified: unknown node"); return -1; }
+    const int idx = n->paramIndex(key);
+    if (idx < 0) {
+        eng::c_error(std::string("param_modified: '") + n->type->name + "' has no param '" + key + "'");
+        return -1;
+    }
+    return n->paramModified[idx] ? 1 : 0;
+}
+
+int engine_graph_connect(engine_graph_t g, int from_node, int from_output_idx, int to_node, int to_input_idx) {
+    if (!g) { eng::c_error("connect: null graph"); return 1; }
+    Graph* gr = as(g);
+    eng::AllocScope scope(*gr, eng::AllocPhase::Build);
+    eng::EditTimer edit(*gr);
+    Node* a = gr->getNode(from_node);
+    Node* b = gr->getNode(to_node);
+    if (!a || !b) { eng::c_error("connect: unknown node id"); return 2; }
+    if (from_output_idx < 0 || from_output_idx >= (int)a->type->outputs.size()) { eng::c_error("connect: from_out OOB"); return 3; }
+    if (to_input_idx   < 0 || to_input_idx   >= (int)b->type->inputs.size()) { eng::c_error("connect: to_in OOB"); return 4; }
+    auto outT = a->type->outputs[from_output_idx];
+    auto inT  = b->type->inputs[to_input_idx];
+    if (outT != inT) { eng::c_error("connect: socket type mismatch"); return 5; }
+    if (!eng::insertEdgeOrder(*gr, a, b)) {
+        eng::c_error("connect: edge " + std::to_string(from_node) + " -> " + std::to_string(to_node) + " would create a cycle");
+        return 6;
+    }
+    eng::linkNodes(*gr, a, from_output_idx, b, to_input_idx);
+    b->modified = true;
+    gr->invalidateSchedule();
+    return 0;
+}
+
+int engine_graph_add_output(engine_graph_t g, int node_id, int out_index) {
+    if (!g) { eng::c_error("add_output: null graph"); return 1; }
+    Graph* gr = as(g);
+    eng::AllocScope scope(*gr, eng::AllocPhase::Build);
+    eng::EditTimer edit(*gr);
+    Node* n = gr->getNode(node_id);
+    if (!n) { eng::c_error("add_output: unknown node id"); return 2; }
+    if (out_index < 0 || out_index >= (int)n->type->outputs.size()) { eng::c_error("add_output: out_index OOB"); return 3; }
+    gr->outputs.push_back({node_id, out_index});
+    n->outputPins++;
+    return 0;
+}
+
+int engine_graph_disconnect(engine_graph_t g, int from_node, int from_output_idx, int to_node, int to_input_idx) {
+    if (!g) { eng::c_error("disconnect: null graph"); return 1; }
+    Graph* gr = as(g);
+    eng::AllocScope scope(*gr, eng::AllocPhase::Build);
+    eng::EditTimer edit(*gr);
+    Node* a = gr->getNode(from_node);
+    Node* b = gr->getNode(to_node);
+    if (!a || !b) { eng::c_error("disconnect: unknown node id"); return 2; }
+    for (size_t k = b->inLinks.size(); k-- > 0;) {  // latest matching edge first
+        const auto& l = b->inLinks[k];
+        if (l.src != a || l.out != from_output_idx || l.in != to_input_idx) continue;
+        eng::unlinkInput(*gr, b, k);
+        b->modified = true;
+        gr->invalidateSchedule();
+        return 0;
+    }
+    eng::c_error("disconnect: no such edge");
+    return 3;
+}
+
+int engine_graph_remove_output(engine_graph_t g, int index) {
+    if (!g) { eng::c_error("remove_output: null graph"); return 1; }
+    Graph* gr = as(g);
+    eng::EditTimer edit(*gr);
+    if (index < 0 || index >= (int)gr->outputs.size()) { eng::c_error("remove_output: index OOB"); return 2; }
+    gr->getNode(gr->outputs[index].node)->outputPins--;
+    gr->outputs.erase(gr->outputs.begin() + index);
+    return 0;
+}
+
+int engine_graph_remove_node(engine_graph_t g, int node_id) {
+    if (!g) { eng::c_error("remove_node: null graph"); return 1; }
+    Graph* gr = as(g);
+    eng::AllocScope scope(*gr, eng::AllocPhase::Build);
+    eng::EditTimer edit(*gr);
+    auto it = gr->nodes.find(node_id);
+    if (it == gr->nodes.end()) { eng::c_error("remove_node: unknown node id"); return 2; }
+    Node* n = it->second.get();
+
+    for (const auto& l : n->inLinks) eng::dropConsumer(l.src, n);
+    gr->edgeCount -= n->inLinks.size();
+    for (Node* c : n->succ) {
+        auto& links = c->inLinks;
+        const size_t before = links.size();
+        links.erase(std::remove_if(links.begin(), links.end(), [n](const Node::Link& l) { return l.src == n; }), links.end());
+        gr->edgeCount -= before - links.size();
+        c->modified = true;
+    }
+    if (n->outputPins) {  // pins shift down, so only output nodes pay O(pins)
+        auto& pins = gr->outputs;
+        pins.erase(std::remove_if(pins.begin(), pins.end(), [node_id](const eng::OutputPin& p) { return p.node == node_id; }), pins.end());
+    }
+    for (auto& kv : n->params) gr->paramHandles.erase(&kv.second);
+
+    gr->removeFromOrder(n);
+    gr->nodes.erase(it);
+    gr->invalidateSchedule();
+    return 0;
+}
+
+int engine_graph_retype_node(engine_graph_t g, int node_id, const char* type) {
+    if (!g || !type) { eng::c_error("retype_node: null args"); return 1; }
+    Graph* gr = as(g);
+    eng::AllocScope scope(*gr, eng::AllocPhase::Build);
+    eng::EditTimer edit(*gr);
+    Node* n = gr->getNode(node_id);
+    if (!n) { eng::c_error("retype_node: unknown node id"); return 2; }
+    const NodeType* nt = gr->registry.find(type);
+    if (!nt) { eng::c_error(std::string("retype_node: unknown type '") + type + "'"); return 3; }
+
+    // Every existing edge and output pin must still fit the new sockets
+    auto misfit = [&](const std::string& what) {
+        eng::c_error("retype_node: " + what + " does not fit type '" + nt->name + "'");
+        return 4;
+    };
+    for (const auto& l : n->inLinks)
+        if (l.in >= (int)nt->inputs.size() || nt->inputs[l.in] != l.src->type->outputs[l.out])
+            return misfit("input " + std::to_string(l.in));
+    for (const Node* c : n->succ)
+        for (const auto& l : c->inLinks)
+            if (l.src == n && (l.out >= (int)nt->outputs.size() || nt->outputs[l.out] != c->type->inputs[l.in]))
+                return misfit("output " + std::to_string(l.out));
+    if (n->outputPins) {
+        for (const auto& p : gr->outputs)
+            if (p.node == node_id && p.outIdx >= (int)nt->outputs.size())
+                return misfit("output pin " + std::to_string(p.outIdx));
+    }
+
+    // Keep parameters the new type declares with the same value type; handles
+    // into the node are released either way since their spec index moves.
+    for (auto pit = n->params.begin(); pit != n->params.end();) {
+        gr->paramHandles.erase(&pit->second);
+        auto spec = std::find_if(nt->params.begin(), nt->params.end(),
+                                 [&](const eng::ParamSpec& ps) { return ps.name == pit->first; });
+        if (spec == nt->params.end() || spec->type != pit->second.type) pit = n->params.erase(pit);
+        else ++pit;
+    }
+    if (n->type != nt && !gr->profile.empty()) gr->profileRetyped = true;
+    n->type = nt;
+    n->inputValues.assign(nt->inputs.size(), Value::num(0.0));
+    n->outputValues.clear();
+    n->paramModified.assign(nt->params.size(), false);
+    n->modified = true;
+    gr->invalidateSchedule();
+    return 0;
+}
+
+int engine_graph_run(engine_graph_t g) {
+    if (!g) { eng::c_error("run: null graph"); return 1; }
+    Graph* gr = as(g);
+    gr->lastError.clear();
+    if (!eng::runGraphTaskflow(*gr)) {
+        eng::c_error(gr->lastError.empty() ? "execution failed" : gr->lastError);
+        return 2;
+    }
     return 0;
 }
 
+int engine_graph_run_batch(engine_graph_t* graphs, int count, int* results) {
+    if (count < 0 || (count > 0 && (!graphs || !results))) { eng::c_error("run_batch: null args"); return 1; }
+    std::vector<Graph*> gs(count);
+    std::unordered_set<Graph*> seen;
+    for (int i = 0; i < count; ++i) {
+        gs[i] = as(graphs[i]);
+        if (!gs[i]) { eng::c_error("run_batch: null graph"); return 1; }
+        if (!seen.insert(gs[i]).second) { eng::c_error("run_batch: graph listed twice"); return 1; }
+        gs[i]->lastError.clear();
+    }
+    std::vector<bool> ok;
+    eng::runGraphsBatch(gs.data(), count, ok);
+    int failed = 0;
+    for (int i = 0; i < count; ++i) {
+        results[i] = ok[i] ? 0 : 2;
+        if (!ok[i] && gs[i]->lastError.empty()) gs[i]->setError("execution failed");
+        failed += !ok[i];
+    }
+    if (failed) eng::c_error("run_batch: " + std::to_string(failed) + " of " + std::to_string(count) + " graphs failed");
+    return failed ? 2 : 0;
+}
+
+const char* engine_graph_last_error(engine_graph_t g) {
+    return g ? as(g)->lastError.c_str() : "";
+}
+
 int engine_graph_get_output_count(engine_graph_t g) {
     Graph* gr = as(g);
     return (int)gr->outputs.size();
@@ -589,6 +2469,7 @@ int engine_graph_get_output_count(engine_graph_t g) {
 
 eng_type_t engine_graph_get_output_type(engine_graph_t g, int index) {
     Graph* gr = as(g);
+    gr->noteExtract();
     if (index < 0 || index >= (int)gr->outputs.size()) return ENG_TYPE_NUMBER;
     auto out = gr->outputs[index];
     Node* n = gr->getNode(out.node);
@@ -600,6 +2481,7 @@ eng_type_t engine_graph_get_output_type(engine_graph_t g, int index) {
 int engine_graph_get_output_number(engine_graph_t g, int index, double* out) {
     if (!g || !out) return 1;
     Graph* gr = as(g);
+    gr->noteExtract();
     if (index < 0 || index >= (int)gr->outputs.size()) return 2;
     auto pin = gr->outputs[index];
     Node* n = gr->getNode(pin.node);
@@ -614,6 +2496,7 @@ int engine_graph_get_output_number(engine_graph_t g, int index, double* out) {
 int engine_graph_get_output_bool(engine_graph_t g, int index, int* out) {
     if (!g || !out) return 1;
     Graph* gr = as(g);
+    gr->noteExtract();
     if (index < 0 || index >= (int)gr->outputs.size()) return 2;
     auto pin = gr->outputs[index];
     Node* n = gr->getNode(pin.node);
@@ -627,6 +2510,8 @@ int engine_graph_get_output_bool(engine_graph_t g, int index, int* out) {
 
 const char* engine_graph_get_output_string(engine_graph_t g, int index) {
     Graph* gr = as(g);
+    eng::AllocScope scope(*gr, eng::AllocPhase::Output);
+    gr->noteExtract();
     if (index < 0 || index >= (int)gr->outputs.size()) return nullptr;
     auto pin = gr->outputs[index];
     Node* n = gr->getNode(pin.node);
@@ -639,31 +2524,136 @@ const char* engine_graph_get_output_string(engine_graph_t g, int index) {
     return s.c_str();
 }
 
+int engine_graph_outputs_to_json(engine_graph_t g, char* buf, size_t cap) {
+    if (!g) { eng::c_error("outputs_to_json: null graph"); return -1; }
+    eng::AllocScope scope(*as(g), eng::AllocPhase::Output);
+    const std::string& json = eng::renderOutputsJson(*as(g));
+    as(g)->noteExtract();
+    if (buf && cap > 0) {
+        const size_t n = std::min(json.size(), cap - 1);
+        memcpy(buf, json.data(), n);
+        buf[n] = '\0';
+    }
+    return (int)json.size();
+}
+
+const char* engine_graph_outputs_json(engine_graph_t g, size_t* len) {
+    if (!g) { eng::c_error("outputs_json: null graph"); return nullptr; }
+    eng::AllocScope scope(*as(g), eng::AllocPhase::Output);
+    const std::string& json = eng::renderOutputsJson(*as(g));
+    as(g)->noteExtract();
+    if (len) *len = json.size();
+    return json.c_str();
+}
+
+int engine_graph_set_profiling(engine_graph_t g, int enabled) {
+    if (!g) { eng::c_error("set_profiling: null graph"); return 1; }
+    as(g)->profiling = enabled != 0;
+    return 0;
+}
+
+const engine_node_profile_t* engine_graph_get_profile(engine_graph_t g, int* count) {
+    if (!g) { eng::c_error("get_profile: null graph"); if (count) *count = 0; return nullptr; }
+    Graph* gr = as(g);
+    if (count) *count = (int)gr->profile.size();
+    return gr->profile.data();
+}
+
+const char* engine_graph_get_profile_json(engine_graph_t g) {
+    if (!g) { eng::c_error("get_profile_json: null graph"); return nullptr; }
+    Graph* gr = as(g);
+    return gr->profileJson.empty() ? "{\"run_us\":0,\"workers\":0,\"nodes\":[]}" : gr->profileJson.c_str();
+}
+
+int engine_graph_set_perf_counters(engine_graph_t g, int mode) {
+    if (!g) { eng::c_error("set_perf_counters: null graph"); return 1; }
+    if (mode < ENG_PERF_OFF || mode > ENG_PERF_NODES) { eng::c_error("set_perf_counters: invalid mode"); return 2; }
+    as(g)->perfMode = mode;
+    return 0;
+}
+
+int engine_graph_get_perf_counters(engine_graph_t g, engine_perf_sample_t* total, unsigned* available) {
+    if (!g) { eng::c_error("get_perf_counters: null graph"); return 1; }
+    Graph* gr = as(g);
+    if (available) *available = eng::perfAvailable();
+    if (total) *total = gr->perfTotal;
+    if (!gr->perfValid) { eng::c_error("get_perf_counters: last run was not counted"); return 2; }
+    return 0;
+}
+
+const engine_perf_sample_t* engine_graph_get_perf_nodes(engine_graph_t g, int* count) {
+    if (!g) { eng::c_error("get_perf_nodes: null graph"); if (count) *count = 0; return nullptr; }
+    Graph* gr = as(g);
+    if (count) *count = (int)gr->perfNodes.size();
+    return gr->perfNodes.data();
+}
+
+const char* engine_graph_get_perf_json(engine_graph_t g) {
+    if (!g) { eng::c_error("get_perf_json: null graph"); return nullptr; }
+    return eng::renderPerfJson(*as(g)).c_str();
+}
+
+int engine_graph_analyze(engine_graph_t g, engine_graph_analysis_t* out) {
+    if (!g || !out) { eng::c_error("analyze: null args"); return 1; }
+    eng::analyzeGraph(*as(g), *out);
+    return 0;
+}
+
+int engine_graph_get_alloc_stats(engine_graph_t g, engine_alloc_stats_t* out) {
+    if (!g || !out) { eng::c_error("get_alloc_stats: null args"); return 1; }
+#ifdef ENGINE_ALLOC_STATS
+    Graph* gr = as(g);
+    using eng::AllocPhase;
+    out->build = gr->ranOnce ? gr->lastBuild : gr->alloc[(int)AllocPhase::Build].snapshot();
+    out->schedule = gr->alloc[(int)AllocPhase::Schedule].snapshot();
+    out->execute = gr->alloc[(int)AllocPhase::Execute].snapshot();
+    out->output = gr->alloc[(int)AllocPhase::Output].snapshot();
+    return 0;
+#else
+    *out = engine_alloc_stats_t{};
+    eng::c_error("get_alloc_stats: library built without ENGINE_ALLOC_STATS");
+    return 2;
+#endif
+}
+
+int engine_metrics_phase_latency(int phase, engine_latency_summary_t* out) {
+    if (!out) { eng::c_error("metrics_phase_latency: null out"); return 1; }
+    if (phase < 0 || phase >= eng::kPhaseCount) { eng::c_error("metrics_phase_latency: invalid phase"); return 2; }
+    eng::summarize(eng::phaseSnapshot(phase), *out);
+    return 0;
+}
+
+int engine_metrics_type_latency(const char* type, engine_latency_summary_t* out) {
+    if (!type || !out) { eng::c_error("metrics_type_latency: null args"); return 1; }
+    *out = engine_latency_summary_t{};
+    if (!eng::globalRegistry().find(type)) { eng::c_error(std::string("metrics_type_latency: unknown type '") + type + "'"); return 2; }
+    for (const auto& [name, snap] : eng::typeSnapshots())
+        if (name == type) eng::summarize(snap, *out);
+    return 0;
+}
+
+void engine_metrics_get_counters(engine_metrics_counters_t* out) {
+    if (out) *out = eng::counterTotals();
+}
+
+const char* engine_metrics_prometheus(void) {
+    static thread_local std::string text;
+    text = eng::renderPrometheus();
+    return text.c_str();
+}
+
+int engine_set_trace_dir(const char* dir) {
+    eng::TraceConfig& c = eng::traceConfig();
+    std::lock_guard<std::mutex> lk(c.mutex);
+    c.dir = dir ? dir : "";
+    c.on = !c.dir.empty();
+    return 0;
+}
+
 const char* engine_last_error(void) { return eng::g_last_error.c_str(); }
 
 const char* engine_list_types(void) {
-    static thread_local std::string typesList;
-    // Create a simple global registry for access without a graph instance
-    static std::once_flag registryInitialized;
-    static std::unordered_map<std::string, NodeType> globalRegistry;
-    
-    std::call_once(registryInitialized, []() {
-        Graph tempGraph; // This will call registerBuiltins()
-        globalRegistry = tempGraph.registry;
-    });
-    
-    std::ostringstream json;
-    json << "[";
-    bool first = true;
-    for (const auto& pair : globalRegistry) {
-        if (!first) json << ",";
-        json << "\"" << eng::escapeJson(pair.first) << "\"";
-        first = false;
-    }
-    json << "]";
-    
-    typesList = json.str();
-    return typesList.c_str();
+    return eng::globalRegistry().catalog().listJson.c_str();
 }
 
 const char* engine_get_type_spec(const char* typeName) {
@@ -672,24 +2662,56 @@ const char* engine_get_type_spec(const char* typeName) {
         return nullptr; 
     }
     
-    static thread_local std::string typeSpec;
-    // Create a simple global registry for access without a graph instance
-    static std::once_flag registryInitialized;
-    static std::unordered_map<std::string, NodeType> globalRegistry;
-    
-    std::call_once(registryInitialized, []() {
-        Graph tempGraph; // This will call registerBuiltins()
-        globalRegistry = tempGraph.registry;
-    });
-    
-    auto it = globalRegistry.find(typeName);
-    if (it == globalRegistry.end()) {
+    const auto& specs = eng::globalRegistry().catalog().specJson;
+    auto it = specs.find(typeName);
+    if (it == specs.end()) {
         eng::c_error(std::string("engine_get_type_spec: unknown type '") + typeName + "'");
         return nullptr;
     }
-    
-    typeSpec = eng::nodeTypeToJson(it->second);
-    return typeSpec.c_str();
+    return it->second.c_str();
+}
+
+const char* engine_get_all_type_specs(void) {
+    return eng::globalRegistry().catalog().catalogJson.c_str();
+}
+
+const char* engine_get_catalog_version(void) {
+    return eng::globalRegistry().catalog().version.c_str();
+}
+
+int engine_load_plugin(const char* path) {
+    if (!path) { eng::c_error("load_plugin: null path"); return 1; }
+    eng::g_last_error.clear();
+    return eng::globalRegistry().loadPlugin(path);
 }
 
 } // extern "C"
+
+#ifdef ENGINE_ALLOC_STATS
+// ========= counting operator new/delete =========
+// Replaces the global allocation functions for the whole process. Block sizes
+// come from malloc_usable_size so frees can be attributed without a header.
+void* operator new(size_t n) {
+    void* p = malloc(n ? n : 1);
+    if (!p) throw std::bad_alloc();
+    if (eng::AllocCounters* c = eng::t_allocScope) c->onAlloc(n, malloc_usable_size(p));
+    return p;
+}
+void* operator new[](size_t n) { return ::operator new(n); }
+void* operator new(size_t n, const std::nothrow_t&) noexcept {
+    try { return ::operator new(n); } catch (...) { return nullptr; }
+}
+void* operator new[](size_t n, const std::nothrow_t&) noexcept {
+    try { return ::operator new(n); } catch (...) { return nullptr; }
+}
+void operator delete(void* p) noexcept {
+    if (!p) return;
+    if (eng::AllocCounters* c = eng::t_allocScope) c->onFree(malloc_usable_size(p));
+    free(p);
+}
+void operator delete[](void* p) noexcept { ::operator delete(p); }
+void operator delete(void* p, size_t) noexcept { ::operator delete(p); }
+void operator delete[](void* p, size_t) noexcept { ::operator delete(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { ::operator delete(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { ::operator delete(p); }
+#endif
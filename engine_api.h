@@ -6,6 +6,7 @@ extern "C" {
 #endif
 
 typedef void* engine_graph_t;
+typedef void* engine_param_t;   // pre-resolved parameter slot, owned by its graph
 
 typedef enum {
     ENG_TYPE_NUMBER = 0,
@@ -25,25 +26,256 @@ int engine_graph_set_param_number(engine_graph_t g, int node_id, const char* key
 int engine_graph_set_param_string(engine_graph_t g, int node_id, const char* key, const char* value);
 int engine_graph_set_param_bool  (engine_graph_t g, int node_id, const char* key, int value);
 
+// Parameter handles: resolve (node, key) once against the node type's ParamSpec,
+// then write straight into the parameter slot. The handle stays valid until the
+// graph is destroyed or its node is removed or retyped; setters fail if the
+// value type does not match the spec.
+engine_param_t engine_graph_param_handle(engine_graph_t g, int node_id, const char* key);
+int engine_param_set_number(engine_param_t p, double value);
+int engine_param_set_string(engine_param_t p, const char* value);
+int engine_param_set_bool  (engine_param_t p, int value);
+
+// 1 if the parameter was set (by key or by handle) since its node last ran
+// successfully, 0 if not, -1 on error (unknown node or a key the type does not
+// declare). Lets a caller see exactly which parameters the next run picks up.
+int engine_param_modified(engine_param_t p);
+int engine_graph_param_modified(engine_graph_t g, int node_id, const char* key);
+
+// Rejects (returns 6) an edge that would create a cycle. The graph keeps a
+// topological order up to date as edges are added, so the check only visits
+// nodes ordered between the two endpoints and runs need no sort.
 int engine_graph_connect(engine_graph_t g,
                          int from_node, int from_output_idx,
                          int to_node,   int to_input_idx);
 
 int engine_graph_add_output(engine_graph_t g, int node_id, int out_index);
 
+// Edits; none of them may run concurrently with a run of g. Adjacency, the
+// topological order and cached node results are updated in place, in time
+// proportional to the degrees of the edited node and its neighbours (plus the
+// output pins, for remove_node on a node that has pins). The compiled
+// schedule is not patched: like add_node and connect, every edit drops it and
+// the next run rebuilds it in O(V + E).
+// disconnect removes the latest matching edge (3 if there is none).
+// remove_output drops pin `index`; later pins shift down by one.
+// remove_node drops the node with its edges and output pins, and invalidates
+// its parameter handles.
+// retype_node swaps the node's type in place, keeping its edges, pins and the
+// parameters the new type declares with the same value type. It fails (4)
+// if an edge or pin does not fit the new sockets. Its parameter handles are
+// invalidated.
+int engine_graph_disconnect(engine_graph_t g,
+                            int from_node, int from_output_idx,
+                            int to_node,   int to_input_idx);
+int engine_graph_remove_output(engine_graph_t g, int index);
+int engine_graph_remove_node(engine_graph_t g, int node_id);
+int engine_graph_retype_node(engine_graph_t g, int node_id, const char* type);
+
+// Runs on the process-wide Taskflow executor ($TAZOR_ENGINE_THREADS workers).
+// Distinct graphs may run concurrently from different threads; a single graph
+// must not be run or modified concurrently.
+// Runs are incremental: after a successful run only nodes with changed
+// parameters, new nodes, nodes whose inputs were connected, disconnected or
+// removed, and everything downstream of them are recomputed.
 int engine_graph_run(engine_graph_t g);
 
+// Runs `count` distinct graphs together as one combined task graph on the
+// shared executor. results[i] is 0 on success or non-zero if graphs[i] failed
+// (see engine_graph_last_error). Returns 0 if every graph succeeded.
+int engine_graph_run_batch(engine_graph_t* graphs, int count, int* results);
+// Error from the graph's last run; empty if it succeeded.
+const char* engine_graph_last_error(engine_graph_t g);
+
 int         engine_graph_get_output_count(engine_graph_t g);
 eng_type_t  engine_graph_get_output_type (engine_graph_t g, int index);
 int         engine_graph_get_output_number(engine_graph_t g, int index, double* out);
 int         engine_graph_get_output_bool  (engine_graph_t g, int index, int* out);
 const char* engine_graph_get_output_string(engine_graph_t g, int index);
 
+// The whole result document in one call:
+//   {"outputs":[{"index":0,"type":"number"|"string"|"bool","value":...},...]}
+// Numbers use the shortest form that round-trips exactly (inf/nan -> null);
+// strings are fully escaped. A pin without a value is {"index":i,"type":"unknown"}.
+// outputs_to_json copies at most cap-1 bytes plus a NUL into buf and returns
+// the full length, so a result >= cap means buf was too small (-1 on error).
+// outputs_json returns a graph-owned buffer valid until the next call, run or
+// destroy of that graph.
+int         engine_graph_outputs_to_json(engine_graph_t g, char* buf, size_t cap);
+const char* engine_graph_outputs_json(engine_graph_t g, size_t* len);
+
+// ========= Profiling =========
+// Opt-in per graph. Profiled runs execute on a separate executor (same size
+// as the shared one) with a Taskflow observer attached; other runs are not
+// instrumented. Batched runs (engine_graph_run_batch) are never profiled.
+typedef struct {
+    int         node_id;
+    const char* type;          // node type name, valid for the process lifetime
+    const char* name;          // node name, valid while the node exists
+    int         worker;        // executor worker that ran the task
+    double      start_us;      // task start, relative to the start of the run
+    double      wall_us;       // task wall time
+    double      queue_us;      // ready (last upstream finished) -> started
+    size_t      input_bytes;   // payload of the node's inputs
+    size_t      output_bytes;  // payload of the node's outputs
+    int         computed;      // 0 if skipped as clean in an incremental run
+} engine_node_profile_t;
+
+int engine_graph_set_profiling(engine_graph_t g, int enabled);
+// Samples of the last run, ordered by start time; empty unless that run was
+// profiled. Valid until the next run or destroy.
+const engine_node_profile_t* engine_graph_get_profile(engine_graph_t g, int* count);
+// Same as {"run_us":..,"workers":..,"nodes":[{"id","type","name","worker",
+// "start_us","wall_us","queue_us","input_bytes","output_bytes","computed"},..]}
+const char* engine_graph_get_profile_json(engine_graph_t g);
+
+// ========= Hardware counters =========
+// Opt-in per graph. While enabled, every node task reads Linux perf_event_open
+// counters on the worker that runs it, and the run total is the sum over the
+// nodes the run computed. Counters the kernel refuses (containers,
+// perf_event_paranoid, no PMU) read as zero and are missing from `available`;
+// the run itself is unaffected. Adds two read() calls per node task.
+typedef enum {
+    ENG_PERF_OFF   = 0,
+    ENG_PERF_RUN   = 1,   // run totals only
+    ENG_PERF_NODES = 2    // run totals and one sample per computed node
+} eng_perf_mode_t;
+
+// Bits of `available`
+#define ENG_PERF_CYCLES           (1u << 0)
+#define ENG_PERF_INSTRUCTIONS     (1u << 1)
+#define ENG_PERF_LLC_MISSES       (1u << 2)
+#define ENG_PERF_BRANCH_MISSES    (1u << 3)
+#define ENG_PERF_CONTEXT_SWITCHES (1u << 4)
+// Set with the counters above when they count user space only (kernel-side
+// counting needs perf_event_paranoid < 2); all counters use the same mode.
+#define ENG_PERF_USER_ONLY        (1u << 31)
+
+typedef struct {
+    int                node_id;   // -1 for the run total
+    unsigned long long cycles;
+    unsigned long long instructions;
+    unsigned long long llc_misses;
+    unsigned long long branch_misses;
+    unsigned long long context_switches;
+} engine_perf_sample_t;
+
+int engine_graph_set_perf_counters(engine_graph_t g, int mode);
+// Totals of the last run. Returns 0 if that run was counted; `available`
+// receives the ENG_PERF_* counters this process can open.
+int engine_graph_get_perf_counters(engine_graph_t g, engine_perf_sample_t* total, unsigned* available);
+// Per-node samples of the last run (ENG_PERF_NODES). Valid until the next run or destroy.
+const engine_perf_sample_t* engine_graph_get_perf_nodes(engine_graph_t g, int* count);
+// {"available":["cycles",..],"user_only":bool,"total":{"cycles":..,..},"nodes":[{"id":..,"cycles":..,..},..]}
+const char* engine_graph_get_perf_json(engine_graph_t g);
+
+// ========= Metrics =========
+// Always on and process-wide: latency histograms per run phase and per node
+// type (log-linear buckets, <= 1/16 relative error) and run counters. Each
+// thread records into its own shard; these calls merge all shards.
+typedef enum {
+    ENG_PHASE_BUILD    = 0,   // time inside edit calls since the previous run
+    ENG_PHASE_SCHEDULE = 1,   // compile (on topology change) + dirty marking
+    ENG_PHASE_EXECUTE  = 2    // task graph execution
+} eng_phase_t;
+
+typedef struct {
+    unsigned long long count;
+    double sum_us;
+    double p50_us, p90_us, p99_us, p999_us;
+    double max_us;
+} engine_latency_summary_t;
+
+typedef struct {
+    unsigned long long runs;            // batched graphs count individually
+    unsigned long long run_failures;
+    unsigned long long nodes_executed;  // computed nodes; clean nodes skipped by incremental runs are not counted
+    unsigned long long output_bytes;    // output pin payloads of successful runs
+} engine_metrics_counters_t;
+
+int  engine_metrics_phase_latency(int phase, engine_latency_summary_t* out);
+// Zero counts for a known type that never ran; non-zero for an unknown type.
+int  engine_metrics_type_latency(const char* type, engine_latency_summary_t* out);
+void engine_metrics_get_counters(engine_metrics_counters_t* out);
+// Everything above in Prometheus text exposition format (tazor_engine_*).
+// Thread-local buffer, valid until the next call on the same thread.
+const char* engine_metrics_prometheus(void);
+
+// ========= Analysis =========
+// Parallelism of the current topology, for sizing worker pools and sharding.
+// Node costs are the measured wall times (us) of the last run if it was
+// profiled, computed every node and no node has been retyped since
+// (measured = 1), otherwise the per-type "cost" estimates from the catalog
+// (measured = 0).
+typedef struct {
+    int    nodes;
+    int    edges;
+    int    depth;          // levels: nodes on the longest dependency chain
+    int    max_width;      // most nodes on one level (level = longest path from a source)
+    double avg_width;      // nodes / depth
+    double work;           // sum of node costs
+    double critical_path;  // span: most expensive dependency chain
+    double parallelism;    // work / critical_path, upper bound on speedup
+    int    measured;
+} engine_graph_analysis_t;
+
+// Returns 0, or non-zero on null arguments.
+int engine_graph_analyze(engine_graph_t g, engine_graph_analysis_t* out);
+
+// ========= Allocation accounting =========
+// Only available when libengine is built with -DENGINE_ALLOC_STATS, which
+// replaces the global operator new/delete of the process with counting
+// versions (a host that replaces them itself takes precedence). Each graph
+// counts its own allocations per phase:
+//   build     edits (add_node, set_param, connect, ...) that preceded the last
+//             run; before the first run, all edits so far
+//   schedule  compiling the schedule and preparing node buffers
+//   execute   node tasks and submitting the run to the executor
+//   output    string/JSON output getters since the last run
+// Parameter-handle setters are not attributed to a graph.
+typedef struct {
+    size_t allocs;
+    size_t frees;
+    size_t bytes;            // requested bytes
+    size_t peak_live_bytes;  // high-water mark of allocated minus freed block bytes
+} engine_alloc_phase_t;
+
+typedef struct {
+    engine_alloc_phase_t build;
+    engine_alloc_phase_t schedule;
+    engine_alloc_phase_t execute;
+    engine_alloc_phase_t output;
+} engine_alloc_stats_t;
+
+// Returns 0, or non-zero (and zeroed stats) without ENGINE_ALLOC_STATS.
+int engine_graph_get_alloc_stats(engine_graph_t g, engine_alloc_stats_t* out);
+
+// ========= Tracing =========
+// With a trace directory set (here or via $TAZOR_TRACE_DIR), every
+// engine_graph_run is written to <dir>/trace-<pid>-<n>.json in Chrome
+// trace-event format (chrome://tracing, ui.perfetto.dev). Lane 0 shows the
+// construction, scheduling, execution and output-extraction phases; each node
+// task is a slice named "<type> <name>" on the lane of the worker that ran it.
+// A run's file is written when its graph runs again or is destroyed, so that
+// output extraction is covered. Traced runs use the profiling executor.
+// NULL or "" turns tracing off.
+int engine_set_trace_dir(const char* dir);
+
 const char* engine_last_error(void);
 
 // NodeSpec registry C API
+// All strings are rendered once when the registry is initialized and stay
+// valid for the lifetime of the process.
 const char* engine_list_types(void);
 const char* engine_get_type_spec(const char* typeName);
+// Full catalog in one document: {"version":"<hash>","types":{"<name>":<spec>,...}}
+const char* engine_get_all_type_specs(void);
+// Content hash of the catalog; changes whenever any type spec changes.
+const char* engine_get_catalog_version(void);
+
+// Load a native node-type plugin (see engine_plugin.h). Its types are added to
+// the process-wide registry and a new catalog version is published. Loading
+// the same library twice is a no-op. Returns 0 on success.
+int engine_load_plugin(const char* path);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,98 @@
+#pragma once
+#include <stddef.h>
+
+#include "engine_api.h"
+
+// ========= Native plugin ABI =========
+//
+// A plugin is a shared object exporting
+//
+//     int engine_plugin_register(const eng_plugin_host_t* host);
+//
+// which calls host->register_node_type(host->context, &desc) once per node
+// type and returns 0 on success. Load it with engine_load_plugin(path) or by
+// listing it in $TAZOR_PLUGINS (colon-separated) before the registry is first
+// used. Registered types land in the global registry next to the built-ins and
+// their kernel is called directly from the node task.
+//
+// Everything here is plain C so plugins can be built with any compiler and
+// flags (e.g. -O3 -march=native) independently of libengine.so.
+//
+//     static int scale(eng_kernel_io_t* io) {
+//         io->outputs[0].number = io->inputs[0].number * io->params[0].number;
+//         return 0;
+//     }
+//     int engine_plugin_register(const eng_plugin_host_t* host) {
+//         if (host->abi_version != ENGINE_PLUGIN_ABI_VERSION) return 1;
+//         static const eng_type_t io[] = { ENG_TYPE_NUMBER };
+//         static const eng_param_desc_t params[] = {
+//             { "factor", ENG_TYPE_NUMBER, { ENG_TYPE_NUMBER, 1.0, 0, NULL }, NULL, 0, "Scale factor" },
+//         };
+//         eng_node_type_desc_t d = { "Scale", "1.0.0", "Multiplies by a constant",
+//                                    io, 1, io, 1, params, 1, scale, NULL };
+//         return host->register_node_type(host->context, &d);
+//     }
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ENGINE_PLUGIN_ABI_VERSION 1
+#define ENGINE_PLUGIN_ENTRY "engine_plugin_register"
+
+// Value crossing the plugin boundary. Only the field matching `type` is meaningful.
+typedef struct {
+    eng_type_t  type;
+    double      number;
+    int         boolean;
+    const char* string;   // NUL-terminated
+} eng_value_t;
+
+// Per-call kernel I/O.
+// - inputs/params are owned by the engine and valid for the duration of the call;
+//   params follow the declared ParamSpec order with defaults applied.
+// - outputs arrive typed per the node type; output strings must stay valid until
+//   the kernel returns (the engine copies them).
+// - on failure return non-zero and optionally point `error` at a message.
+typedef struct {
+    const eng_value_t* inputs;  int input_count;
+    const eng_value_t* params;  int param_count;
+    eng_value_t*       outputs; int output_count;
+    void*              user_data;
+    const char*        error;
+} eng_kernel_io_t;
+
+typedef int (*eng_kernel_fn)(eng_kernel_io_t* io);
+
+typedef struct {
+    const char*        name;
+    eng_type_t         type;
+    eng_value_t        default_value;
+    const char* const* enum_options;  // NULL if not an enum
+    int                enum_count;
+    const char*        description;
+} eng_param_desc_t;
+
+typedef struct {
+    const char*             name;
+    const char*             version;
+    const char*             description;
+    const eng_type_t*       inputs;  int input_count;
+    const eng_type_t*       outputs; int output_count;
+    const eng_param_desc_t* params;  int param_count;
+    eng_kernel_fn           kernel;
+    void*                   user_data;  // passed back in eng_kernel_io_t
+} eng_node_type_desc_t;
+
+typedef struct {
+    int   abi_version;
+    void* context;
+    // Copies the descriptor; returns 0 on success, non-zero on invalid or duplicate types.
+    int (*register_node_type)(void* context, const eng_node_type_desc_t* desc);
+} eng_plugin_host_t;
+
+typedef int (*eng_plugin_register_fn)(const eng_plugin_host_t* host);
+
+#ifdef __cplusplus
+}
+#endif
@@ -29,10 +29,8 @@ ensure_taskflow() {
 
 ensure_luajit_vendored() {
   # Build vendored LuaJIT to scripts/bin (no system install)
-  if [ -x scripts/bin/luajit ]; then
-    log "LuaJIT already built at scripts/bin/luajit"
-    return 0
-  fi
+  # libluajit.a is linked into libengine.so (LuaScript nodes); build_luajit.sh
+  # skips the build when both exist and were built with the current flags
   if [ ! -d luajit ] || [ ! -f luajit/src/Makefile ]; then
     log "Cloning LuaJIT source"
     rm -rf luajit
@@ -46,7 +44,7 @@ ensure_luajit_vendored() {
     # Vendor as deep copy (strip nested .git to avoid nested repo confusion)
     rm -rf luajit/.git
   fi
-  log "Building LuaJIT locally"
+  log "Building LuaJIT locally (if needed)"
   bash scripts/build_luajit.sh || { log "LuaJIT build failed"; exit 1; }
 }
 
@@ -57,10 +55,34 @@ ensure_node_deps() {
 
 build_engine_so() {
   log "Building libengine.so"
-  g++ -std=c++17 -fPIC -shared engine_api.cpp -Ithird_party/taskflow -pthread -o libengine.so
+  # LuaJIT is linked statically with its symbols hidden, so the engine keeps its
+  # own copy even when loaded into the luajit FFI driver process.
+  # Extra flags via $ENGINE_CXXFLAGS, e.g. -DENGINE_ALLOC_STATS
+  g++ -std=c++17 -fPIC -shared ${ENGINE_CXXFLAGS:-} engine_api.cpp -Ithird_party/taskflow -Iluajit/src \
+    luajit/src/libluajit.a -pthread -ldl -Wl,--exclude-libs,ALL -o libengine.so
   cp -f libengine.so scripts/libengine.so || true
 }
 
+build_engine_bench() {
+  # Standalone benchmark (bench/engine_bench.cpp); not needed by the server
+  log "Building engine_bench"
+  g++ -std=c++17 -O2 bench/engine_bench.cpp -I. -L. -lengine -Wl,-rpath,'$ORIGIN' -pthread \
+    -o engine_bench || log "engine_bench build failed; continuing without it"
+}
+
+build_engine_addon() {
+  # In-process N-API binding; server.js falls back to LuaJIT workers without it
+  local node_inc
+  node_inc="$(dirname "$(dirname "$(command -v node)")")/include/node"
+  if [ ! -f "$node_inc/node_api.h" ]; then
+    log "Node headers not found at $node_inc; skipping engine addon"
+    return 0
+  fi
+  log "Building scripts/engine_addon.node"
+  g++ -std=c++17 -fPIC -shared scripts/addon/engine_addon.cc -I"$node_inc" \
+    -Lscripts -lengine -Wl,-rpath,'$ORIGIN' -o scripts/engine_addon.node || log "engine addon build failed; continuing without it"
+}
+
 start_server() {
   # Prefer vendored LuaJIT via LUAJIT env for clarity; server also auto-detects
   export LUAJIT="$(pwd)/scripts/bin/luajit"
@@ -74,4 +96,6 @@ ensure_taskflow
 ensure_luajit_vendored
 ensure_node_deps
 build_engine_so
+build_engine_bench
+build_engine_addon
 start_server
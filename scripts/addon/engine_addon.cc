@@ -0,0 +1,572 @@
+// In-process Node binding for libengine (N-API, no extra npm dependencies).
+//
+// Exposes the engine C API to server.js without the spawn/LuaJIT/pipe hop:
+//   catalog(), listTypes(), typeSpec(name), catalogVersion()
+//   new Graph(): addNode, setParam, connect, addOutput, outputs, dispose,
+//                disconnect, removeNode, removeOutput, retypeNode,
+//                run() -> Promise<outputs>,
+//                runJson() -> Promise<'{"outputs":[...]}'> (rendered by the engine),
+//                setProfiling(on), profile() -> JSON of the last profiled run
+//   runBatch([Graph...]) -> Promise<[outputs | Error, ...]>
+// Graph.run() hands engine_graph_run to a libuv threadpool thread, which blocks
+// on the engine's shared Taskflow executor until the run ends: the event loop
+// never waits on a run, but each run in flight holds one pool thread (runBatch
+// holds one for the whole batch). libuv starts 4 threads by default, so callers
+// that allow more concurrent runs size UV_THREADPOOL_SIZE to match
+// (engine_native.reserveRunThreads).
+//
+// Built by run.sh into scripts/engine_addon.node (linked against scripts/libengine.so).
+#include <node_api.h>
+
+#include <string>
+#include <vector>
+
+#include "../../engine_api.h"
+
+namespace {
+
+#define NAPI_CALL(env, call)                                        \
+    do {                                                            \
+        if ((call) != napi_ok) {                                    \
+            napi_throw_error((env), nullptr, "napi call failed: " #call); \
+            return nullptr;                                         \
+        }                                                           \
+    } while (0)
+
+struct GraphWrap {
+    engine_graph_t g = nullptr;
+    bool running = false;
+    // run() state
+    napi_async_work work = nullptr;
+    napi_deferred deferred = nullptr;
+    napi_ref self = nullptr;  // keeps the JS object alive while running
+    bool json = false;        // resolve with the engine's JSON document
+    int rc = 0;
+    std::string err;
+};
+
+napi_value throwEngineError(napi_env env, const char* ctx) {
+    const char* e = engine_last_error();
+    std::string msg = std::string(ctx) + ": " + (e && *e ? e : "engine error");
+    napi_throw_error(env, nullptr, msg.c_str());
+    return nullptr;
+}
+
+napi_value str(napi_env env, const char* s) {
+    napi_value v;
+    if (!s) { napi_get_null(env, &v); return v; }
+    napi_create_string_utf8(env, s, NAPI_AUTO_LENGTH, &v);
+    return v;
+}
+
+bool getInt(napi_env env, napi_value v, int* out) {
+    return napi_get_value_int32(env, v, out) == napi_ok;
+}
+
+bool getString(napi_env env, napi_value v, std::string* out) {
+    size_t len = 0;
+    if (napi_get_value_string_utf8(env, v, nullptr, 0, &len) != napi_ok) return false;
+    out->resize(len);
+    size_t copied = 0;
+    if (napi_get_value_string_utf8(env, v, out->data(), len + 1, &copied) != napi_ok) return false;
+    out->resize(copied);
+    return true;
+}
+
+// Unwraps `this` and fetches up to N args.
+template <size_t N>
+GraphWrap* unwrap(napi_env env, napi_callback_info info, napi_value (&argv)[N], size_t* argc) {
+    napi_value self;
+    *argc = N;
+    if (napi_get_cb_info(env, info, argc, argv, &self, nullptr) != napi_ok) return nullptr;
+    GraphWrap* w = nullptr;
+    if (napi_unwrap(env, self, reinterpret_cast<void**>(&w)) != napi_ok || !w) {
+        napi_throw_type_error(env, nullptr, "not an engine Graph");
+        return nullptr;
+    }
+    if (!w->g) { napi_throw_error(env, nullptr, "graph disposed"); return nullptr; }
+    if (w->running) { napi_throw_error(env, nullptr, "graph is running"); return nullptr; }
+    return w;
+}
+
+// ---- module-level functions ----
+
+napi_value Catalog(napi_env env, napi_callback_info) { return str(env, engine_get_all_type_specs()); }
+napi_value CatalogVersion(napi_env env, napi_callback_info) { return str(env, engine_get_catalog_version()); }
+napi_value ListTypes(napi_env env, napi_callback_info) { return str(env, engine_list_types()); }
+napi_value Metrics(napi_env env, napi_callback_info) { return str(env, engine_metrics_prometheus()); }
+
+napi_value TypeSpec(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1];
+    NAPI_CALL(env, napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr));
+    std::string name;
+    if (argc < 1 || !getString(env, argv[0], &name)) {
+        napi_throw_type_error(env, nullptr, "typeSpec(name: string)");
+        return nullptr;
+    }
+    return str(env, engine_get_type_spec(name.c_str()));  // null if unknown
+}
+
+// ---- Graph ----
+
+void GraphFinalize(napi_env, void* data, void*) {
+    auto* w = static_cast<GraphWrap*>(data);
+    if (w->g) engine_graph_destroy(w->g);
+    delete w;
+}
+
+napi_value GraphNew(napi_env env, napi_callback_info info) {
+    napi_value self;
+    NAPI_CALL(env, napi_get_cb_info(env, info, nullptr, nullptr, &self, nullptr));
+    auto* w = new GraphWrap();
+    w->g = engine_graph_create();
+    if (!w->g) { delete w; return throwEngineError(env, "engine_graph_create"); }
+    if (napi_wrap(env, self, w, GraphFinalize, nullptr, nullptr) != napi_ok) {
+        engine_graph_destroy(w->g);
+        delete w;
+        napi_throw_error(env, nullptr, "napi_wrap failed");
+        return nullptr;
+    }
+    return self;
+}
+
+// addNode(id, type, name?)
+napi_value GraphAddNode(napi_env env, napi_callback_info info) {
+    napi_value argv[3];
+    size_t argc;
+    GraphWrap* w = unwrap(env, info, argv, &argc);
+    if (!w) return nullptr;
+    int id;
+    std::string type, name;
+    if (argc < 2 || !getInt(env, argv[0], &id) || !getString(env, argv[1], &type)) {
+        napi_throw_type_error(env, nullptr, "addNode(id: number, type: string, name?: string)");
+        return nullptr;
+    }
+    const bool hasName = argc > 2 && getString(env, argv[2], &name);
+    if (engine_graph_add_node_with_id(w->g, id, type.c_str(), hasName ? name.c_str() : nullptr) != 0)
+        return throwEngineError(env, ("add_node " + type).c_str());
+    return nullptr;
+}
+
+// setParam(id, key, value): number, boolean or string by JS type
+napi_value GraphSetParam(napi_env env, napi_callback_info info) {
+    napi_value argv[3];
+    size_t argc;
+    GraphWrap* w = unwrap(env, info, argv, &argc);
+    if (!w) return nullptr;
+    int id;
+    std::string key;
+    if (argc < 3 || !getInt(env, argv[0], &id) || !getString(env, argv[1], &key)) {
+        napi_throw_type_error(env, nullptr, "setParam(id: number, key: string, value)");
+        return nullptr;
+    }
+    napi_valuetype t;
+    NAPI_CALL(env, napi_typeof(env, argv[2], &t));
+    int rc;
+    if (t == napi_number) {
+        double d;
+        NAPI_CALL(env, napi_get_value_double(env, argv[2], &d));
+        rc = engine_graph_set_param_number(w->g, id, key.c_str(), d);
+    } else if (t == napi_boolean) {
+        bool b;
+        NAPI_CALL(env, napi_get_value_bool(env, argv[2], &b));
+        rc = engine_graph_set_param_bool(w->g, id, key.c_str(), b ? 1 : 0);
+    } else {
+        napi_value sv;
+        std::string s;
+        NAPI_CALL(env, napi_coerce_to_string(env, argv[2], &sv));
+        if (!getString(env, sv, &s)) { napi_throw_type_error(env, nullptr, "setParam: bad value"); return nullptr; }
+        rc = engine_graph_set_param_string(w->g, id, key.c_str(), s.c_str());
+    }
+    if (rc != 0) return throwEngineError(env, ("set_param " + key).c_str());
+    return nullptr;
+}
+
+// connect(from, fromOutput, to, toInput)
+napi_value GraphConnect(napi_env env, napi_callback_info info) {
+    napi_value argv[4];
+    size_t argc;
+    GraphWrap* w = unwrap(env, info, argv, &argc);
+    if (!w) return nullptr;
+    int a, ao, b, bi;
+    if (argc < 4 || !getInt(env, argv[0], &a) || !getInt(env, argv[1], &ao) ||
+        !getInt(env, argv[2], &b) || !getInt(env, argv[3], &bi)) {
+        napi_throw_type_error(env, nullptr, "connect(from, fromOutput, to, toInput)");
+        return nullptr;
+    }
+    if (engine_graph_connect(w->g, a, ao, b, bi) != 0) return throwEngineError(env, "connect");
+    return nullptr;
+}
+
+// addOutput(node, output)
+napi_value GraphAddOutput(napi_env env, napi_callback_info info) {
+    napi_value argv[2];
+    size_t argc;
+    GraphWrap* w = unwrap(env, info, argv, &argc);
+    if (!w) return nullptr;
+    int n, o;
+    if (argc < 2 || !getInt(env, argv[0], &n) || !getInt(env, argv[1], &o)) {
+        napi_throw_type_error(env, nullptr, "addOutput(node, output)");
+        return nullptr;
+    }
+    if (engine_graph_add_output(w->g, n, o) != 0) return throwEngineError(env, "add_output");
+    return nullptr;
+}
+
+// disconnect(from, fromOutput, to, toInput)
+napi_value GraphDisconnect(napi_env env, napi_callback_info info) {
+    napi_value argv[4];
+    size_t argc;
+    GraphWrap* w = unwrap(env, info, argv, &argc);
+    if (!w) return nullptr;
+    int a, ao, b, bi;
+    if (argc < 4 || !getInt(env, argv[0], &a) || !getInt(env, argv[1], &ao) ||
+        !getInt(env, argv[2], &b) || !getInt(env, argv[3], &bi)) {
+        napi_throw_type_error(env, nullptr, "disconnect(from, fromOutput, to, toInput)");
+        return nullptr;
+    }
+    if (engine_graph_disconnect(w->g, a, ao, b, bi) != 0) return throwEngineError(env, "disconnect");
+    return nullptr;
+}
+
+// removeNode(id)
+napi_value GraphRemoveNode(napi_env env, napi_callback_info info) {
+    napi_value argv[1];
+    size_t argc;
+    GraphWrap* w = unwrap(env, info, argv, &argc);
+    if (!w) return nullptr;
+    int id;
+    if (argc < 1 || !getInt(env, argv[0], &id)) {
+        napi_throw_type_error(env, nullptr, "removeNode(id: number)");
+        return nullptr;
+    }
+    if (engine_graph_remove_node(w->g, id) != 0) return throwEngineError(env, "remove_node");
+    return nullptr;
+}
+
+// removeOutput(index)
+napi_value GraphRemoveOutput(napi_env env, napi_callback_info info) {
+    napi_value argv[1];
+    size_t argc;
+    GraphWrap* w = unwrap(env, info, argv, &argc);
+    if (!w) return nullptr;
+    int index;
+    if (argc < 1 || !getInt(env, argv[0], &index)) {
+        napi_throw_type_error(env, nullptr, "removeOutput(index: number)");
+        return nullptr;
+    }
+    if (engine_graph_remove_output(w->g, index) != 0) return throwEngineError(env, "remove_output");
+    return nullptr;
+}
+
+// retypeNode(id, type)
+napi_value GraphRetypeNode(napi_env env, napi_callback_info info) {
+    napi_value argv[2];
+    size_t argc;
+    GraphWrap* w = unwrap(env, info, argv, &argc);
+    if (!w) return nullptr;
+    int id;
+    std::string type;
+    if (argc < 2 || !getInt(env, argv[0], &id) || !getString(env, argv[1], &type)) {
+        napi_throw_type_error(env, nullptr, "retypeNode(id: number, type: string)");
+        return nullptr;
+    }
+    if (engine_graph_retype_node(w->g, id, type.c_str()) != 0) return throwEngineError(env, ("retype_node " + type).c_str());
+    return nullptr;
+}
+
+// [{index, type, value}, ...] in one pass over the output pins
+napi_value collectOutputs(napi_env env, engine_graph_t g) {
+    const int count = engine_graph_get_output_count(g);
+    napi_value arr;
+    NAPI_CALL(env, napi_create_array_with_length(env, count, &arr));
+    for (int i = 0; i < count; ++i) {
+        napi_value o, idx, value;
+        NAPI_CALL(env, napi_create_object(env, &o));
+        NAPI_CALL(env, napi_create_int32(env, i, &idx));
+        const char* type;
+        switch (engine_graph_get_output_type(g, i)) {
+            case ENG_TYPE_NUMBER: {
+                double d = 0;
+                engine_graph_get_output_number(g, i, &d);
+                napi_create_double(env, d, &value);
+                type = "number";
+                break;
+            }
+            case ENG_TYPE_STRING: {
+                const char* s = engine_graph_get_output_string(g, i);
+                value = str(env, s ? s : "");
+                type = "string";
+                break;
+            }
+            case ENG_TYPE_BOOL: {
+                int b = 0;
+                engine_graph_get_output_bool(g, i, &b);
+                napi_get_boolean(env, b != 0, &value);
+                type = "bool";
+                break;
+            }
+            default:
+                napi_get_null(env, &value);
+                type = "unknown";
+        }
+        NAPI_CALL(env, napi_set_named_property(env, o, "index", idx));
+        NAPI_CALL(env, napi_set_named_property(env, o, "type", str(env, type)));
+        NAPI_CALL(env, napi_set_named_property(env, o, "value", value));
+        NAPI_CALL(env, napi_set_element(env, arr, i, o));
+    }
+    return arr;
+}
+
+napi_value GraphOutputs(napi_env env, napi_callback_info info) {
+    napi_value argv[1];
+    size_t argc;
+    GraphWrap* w = unwrap(env, info, argv, &argc);
+    if (!w) return nullptr;
+    return collectOutputs(env, w->g);
+}
+
+// setProfiling(enabled)
+napi_value GraphSetProfiling(napi_env env, napi_callback_info info) {
+    napi_value argv[1];
+    size_t argc;
+    GraphWrap* w = unwrap(env, info, argv, &argc);
+    if (!w) return nullptr;
+    bool on = false;
+    if (argc < 1 || napi_get_value_bool(env, argv[0], &on) != napi_ok) {
+        napi_throw_type_error(env, nullptr, "setProfiling(enabled: boolean)");
+        return nullptr;
+    }
+    engine_graph_set_profiling(w->g, on ? 1 : 0);
+    return nullptr;
+}
+
+// profile(): engine_graph_get_profile_json of the last run
+napi_value GraphProfile(napi_env env, napi_callback_info info) {
+    napi_value argv[1];
+    size_t argc;
+    GraphWrap* w = unwrap(env, info, argv, &argc);
+    if (!w) return nullptr;
+    return str(env, engine_graph_get_profile_json(w->g));
+}
+
+// Releases the engine graph now instead of waiting for GC.
+napi_value GraphDispose(napi_env env, napi_callback_info info) {
+    napi_value argv[1];
+    size_t argc;
+    GraphWrap* w = unwrap(env, info, argv, &argc);
+    if (!w) return nullptr;
+    engine_graph_destroy(w->g);
+    w->g = nullptr;
+    return nullptr;
+}
+
+void RunExecute(napi_env, void* data) {
+    auto* w = static_cast<GraphWrap*>(data);
+    w->rc = engine_graph_run(w->g);
+    if (w->rc != 0) {
+        const char* e = engine_last_error();  // thread-local: read on this thread
+        w->err = e && *e ? e : "run failed";
+    }
+}
+
+void RunComplete(napi_env env, napi_status status, void* data) {
+    auto* w = static_cast<GraphWrap*>(data);
+    w->running = false;
+    napi_value result;
+    if (status != napi_ok || w->rc != 0) {
+        napi_value msg;
+        const std::string text = status != napi_ok ? std::string("run cancelled") : w->err;
+        napi_create_string_utf8(env, text.c_str(), NAPI_AUTO_LENGTH, &msg);
+        napi_create_error(env, nullptr, msg, &result);
+        napi_reject_deferred(env, w->deferred, result);
+    } else {
+        if (w->json) {
+            size_t len = 0;
+            const char* doc = engine_graph_outputs_json(w->g, &len);
+            napi_create_string_utf8(env, doc ? doc : "{\"outputs\":[]}", doc ? len : NAPI_AUTO_LENGTH, &result);
+        } else {
+            result = collectOutputs(env, w->g);
+        }
+        if (!result) {  // collectOutputs threw
+            napi_value exc;
+            napi_get_and_clear_last_exception(env, &exc);
+            napi_reject_deferred(env, w->deferred, exc);
+        } else {
+            napi_resolve_deferred(env, w->deferred, result);
+        }
+    }
+    napi_delete_async_work(env, w->work);
+    napi_delete_reference(env, w->self);
+    w->work = nullptr;
+    w->deferred = nullptr;
+    w->self = nullptr;
+}
+
+napi_value startRun(napi_env env, napi_callback_info info, bool json) {
+    napi_value self;
+    size_t argc = 0;
+    NAPI_CALL(env, napi_get_cb_info(env, info, &argc, nullptr, &self, nullptr));
+    GraphWrap* w = nullptr;
+    NAPI_CALL(env, napi_unwrap(env, self, reinterpret_cast<void**>(&w)));
+    if (!w->g) { napi_throw_error(env, nullptr, "graph disposed"); return nullptr; }
+    if (w->running) { napi_throw_error(env, nullptr, "graph is already running"); return nullptr; }
+
+    napi_value promise, name;
+    NAPI_CALL(env, napi_create_promise(env, &w->deferred, &promise));
+    NAPI_CALL(env, napi_create_string_utf8(env, "engine_graph_run", NAPI_AUTO_LENGTH, &name));
+    NAPI_CALL(env, napi_create_reference(env, self, 1, &w->self));
+    NAPI_CALL(env, napi_create_async_work(env, nullptr, name, RunExecute, RunComplete, w, &w->work));
+    w->running = true;
+    w->json = json;
+    w->err.clear();
+    NAPI_CALL(env, napi_queue_async_work(env, w->work));
+    return promise;
+}
+
+napi_value GraphRun(napi_env env, napi_callback_info info) { return startRun(env, info, false); }
+napi_value GraphRunJson(napi_env env, napi_callback_info info) { return startRun(env, info, true); }
+
+// ---- runBatch ----
+
+struct BatchWork {
+    std::vector<GraphWrap*> wraps;
+    std::vector<engine_graph_t> graphs;
+    std::vector<napi_ref> refs;  // keep the JS graphs alive while running
+    std::vector<int> rc;
+    std::vector<std::string> errs;
+    napi_async_work work = nullptr;
+    napi_deferred deferred = nullptr;
+};
+
+void BatchExecute(napi_env, void* data) {
+    auto* b = static_cast<BatchWork*>(data);
+    engine_graph_run_batch(b->graphs.data(), (int)b->graphs.size(), b->rc.data());
+    for (size_t i = 0; i < b->graphs.size(); ++i) {
+        if (b->rc[i] == 0) continue;
+        const char* e = engine_graph_last_error(b->graphs[i]);
+        b->errs[i] = e && *e ? e : "run failed";
+    }
+}
+
+void BatchComplete(napi_env env, napi_status status, void* data) {
+    auto* b = static_cast<BatchWork*>(data);
+    napi_value arr = nullptr;
+    if (status == napi_ok) napi_create_array_with_length(env, b->wraps.size(), &arr);
+    for (size_t i = 0; i < b->wraps.size(); ++i) {
+        b->wraps[i]->running = false;
+        if (!arr) continue;
+        napi_value item = nullptr;
+        if (b->rc[i] == 0) item = collectOutputs(env, b->graphs[i]);
+        if (!item) {  // failed run, or collectOutputs threw
+            napi_value msg, exc;
+            if (b->rc[i] == 0 && napi_get_and_clear_last_exception(env, &exc) == napi_ok) {
+                item = exc;
+            } else {
+                napi_create_string_utf8(env, b->errs[i].c_str(), NAPI_AUTO_LENGTH, &msg);
+                napi_create_error(env, nullptr, msg, &item);
+            }
+        }
+        napi_set_element(env, arr, i, item);
+    }
+    if (arr) {
+        napi_resolve_deferred(env, b->deferred, arr);
+    } else {
+        napi_value msg, err;
+        napi_create_string_utf8(env, "run cancelled", NAPI_AUTO_LENGTH, &msg);
+        napi_create_error(env, nullptr, msg, &err);
+        napi_reject_deferred(env, b->deferred, err);
+    }
+    for (napi_ref r : b->refs) napi_delete_reference(env, r);
+    napi_delete_async_work(env, b->work);
+    delete b;
+}
+
+// runBatch(graphs): runs every graph in one combined engine task graph.
+// Resolves to one entry per graph, in order: its outputs or an Error.
+napi_value RunBatch(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1];
+    NAPI_CALL(env, napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr));
+    bool isArray = false;
+    if (argc < 1 || napi_is_array(env, argv[0], &isArray) != napi_ok || !isArray) {
+        napi_throw_type_error(env, nullptr, "runBatch(graphs: Graph[])");
+        return nullptr;
+    }
+    uint32_t n = 0;
+    NAPI_CALL(env, napi_get_array_length(env, argv[0], &n));
+
+    auto* b = new BatchWork();
+    for (uint32_t i = 0; i < n; ++i) {
+        napi_value el;
+        GraphWrap* w = nullptr;
+        const char* bad = nullptr;
+        if (napi_get_element(env, argv[0], i, &el) != napi_ok ||
+            napi_unwrap(env, el, reinterpret_cast<void**>(&w)) != napi_ok || !w) bad = "runBatch: not an engine Graph";
+        else if (!w->g) bad = "runBatch: graph disposed";
+        else if (w->running) bad = "runBatch: graph is already running";
+        else {
+            for (GraphWrap* x : b->wraps) if (x == w) bad = "runBatch: graph listed twice";
+        }
+        if (bad) {
+            for (napi_ref r : b->refs) napi_delete_reference(env, r);
+            delete b;
+            napi_throw_error(env, nullptr, bad);
+            return nullptr;
+        }
+        napi_ref ref;
+        NAPI_CALL(env, napi_create_reference(env, el, 1, &ref));
+        b->wraps.push_back(w);
+        b->graphs.push_back(w->g);
+        b->refs.push_back(ref);
+    }
+    b->rc.assign(n, 0);
+    b->errs.assign(n, std::string());
+
+    napi_value promise, name;
+    NAPI_CALL(env, napi_create_promise(env, &b->deferred, &promise));
+    NAPI_CALL(env, napi_create_string_utf8(env, "engine_graph_run_batch", NAPI_AUTO_LENGTH, &name));
+    NAPI_CALL(env, napi_create_async_work(env, nullptr, name, BatchExecute, BatchComplete, b, &b->work));
+    for (GraphWrap* w : b->wraps) w->running = true;
+    NAPI_CALL(env, napi_queue_async_work(env, b->work));
+    return promise;
+}
+
+napi_value Init(napi_env env, napi_value exports) {
+    const napi_property_descriptor fns[] = {
+        {"catalog", nullptr, Catalog, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"catalogVersion", nullptr, CatalogVersion, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"listTypes", nullptr, ListTypes, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"typeSpec", nullptr, TypeSpec, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"runBatch", nullptr, RunBatch, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"metrics", nullptr, Metrics, nullptr, nullptr, nullptr, napi_default, nullptr},
+    };
+    NAPI_CALL(env, napi_define_properties(env, exports, sizeof(fns) / sizeof(fns[0]), fns));
+
+    const napi_property_descriptor methods[] = {
+        {"addNode", nullptr, GraphAddNode, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"setParam", nullptr, GraphSetParam, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"connect", nullptr, GraphConnect, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"addOutput", nullptr, GraphAddOutput, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"disconnect", nullptr, GraphDisconnect, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"removeNode", nullptr, GraphRemoveNode, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"removeOutput", nullptr, GraphRemoveOutput, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"retypeNode", nullptr, GraphRetypeNode, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"outputs", nullptr, GraphOutputs, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"dispose", nullptr, GraphDispose, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"setProfiling", nullptr, GraphSetProfiling, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"profile", nullptr, GraphProfile, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"run", nullptr, GraphRun, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"runJson", nullptr, GraphRunJson, nullptr, nullptr, nullptr, napi_default, nullptr},
+    };
+    napi_value cls;
+    NAPI_CALL(env, napi_define_class(env, "Graph", NAPI_AUTO_LENGTH, GraphNew, nullptr,
+                                     sizeof(methods) / sizeof(methods[0]), methods, &cls));
+    NAPI_CALL(env, napi_set_named_property(env, exports, "Graph", cls));
+    return exports;
+}
+
+}  // namespace
+
+NAPI_MODULE(engine_addon, Init)
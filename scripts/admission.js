@@ -0,0 +1,70 @@
+// Admission control for graph runs.
+//
+// At most `concurrency` runs execute at once; up to `queueLimit` more wait in
+// FIFO order. Anything beyond that is rejected immediately with a QueueFull
+// error carrying a Retry-After estimate, so overload turns into fast 503s
+// instead of unbounded queueing and head-of-line blocking.
+class QueueFullError extends Error {
+  constructor(retryAfterSec) {
+    super('run queue full');
+    this.retryAfterSec = retryAfterSec;
+  }
+}
+
+class Admission {
+  constructor({ concurrency, queueLimit }) {
+    this.concurrency = Math.max(1, concurrency | 0);
+    this.queueLimit = Math.max(0, queueLimit | 0);
+    this.running = 0;
+    this.waiting = [];
+    this.avgRunMs = 10; // EWMA of run durations, feeds Retry-After
+  }
+
+  // Runs fn() once a slot is free. Rejects with QueueFullError when saturated.
+  async run(fn) {
+    if (this.running >= this.concurrency) {
+      if (this.waiting.length >= this.queueLimit) throw new QueueFullError(this.retryAfterSec());
+      await new Promise((resolve) => this.waiting.push(resolve));
+    } else {
+      this.running++;
+    }
+    const start = Date.now();
+    try {
+      return await fn();
+    } finally {
+      this.avgRunMs = 0.9 * this.avgRunMs + 0.1 * (Date.now() - start);
+      const next = this.waiting.shift();
+      if (next) next(); // hand the slot over directly
+      else this.running--;
+    }
+  }
+
+  // Expected time for the current backlog to drain, in whole seconds.
+  retryAfterSec() {
+    const backlog = this.waiting.length + this.running;
+    return Math.max(1, Math.ceil((backlog * this.avgRunMs) / this.concurrency / 1000));
+  }
+
+  stats() {
+    return { running: this.running, queued: this.waiting.length, concurrency: this.concurrency, queueLimit: this.queueLimit };
+  }
+}
+
+// Node type names of a parsed JSON v1 plan or a legacy text plan.
+function planTypes(plan) {
+  if (typeof plan !== 'string') return (plan.nodes || []).map((n) => n.type);
+  const types = [];
+  const re = /^\s*NODE\s+\S+\s+(\S+)/gm;
+  let m;
+  while ((m = re.exec(plan))) types.push(m[1]);
+  return types;
+}
+
+// Estimated plan cost: sum of per-type catalog costs (unknown types count 1).
+function estimateCost(plan, costs) {
+  let total = 0;
+  for (const t of planTypes(plan)) total += costs.get(t) || 1;
+  return total;
+}
+
+module.exports = { Admission, QueueFullError, planTypes, estimateCost };
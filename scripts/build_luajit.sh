@@ -16,7 +16,20 @@ if [ ! -d "$LUADIR" ]; then
   exit 1
 fi
 
-make -C "$LUADIR" -j"$(nproc)"
+# -fPIC: libluajit.a is also linked into libengine.so. The flags are recorded
+# next to the objects; a tree built with other flags (or before the stamp
+# existed, e.g. a non-PIC archive) is cleaned and rebuilt.
+BUILD_FLAGS="CFLAGS=-fPIC"
+STAMP="$LUADIR/src/.build-flags"
+if [ -x scripts/bin/luajit ] && [ -f "$LUADIR/src/libluajit.a" ] && [ "$(cat "$STAMP" 2>/dev/null)" = "$BUILD_FLAGS" ]; then
+  echo "LuaJIT up to date at scripts/bin/luajit"
+  exit 0
+fi
+if [ "$(cat "$STAMP" 2>/dev/null)" != "$BUILD_FLAGS" ]; then
+  make -C "$LUADIR" clean
+fi
+make -C "$LUADIR" -j"$(nproc)" "$BUILD_FLAGS"
+echo "$BUILD_FLAGS" > "$STAMP"
 mkdir -p scripts/bin
 cp "$LUADIR/src/luajit" scripts/bin/
 # Copy shared libs if present
@@ -0,0 +1,63 @@
+const fs = require('fs');
+
+// Plan corpora for offline load replay (see replay.js).
+//
+// A corpus is JSON lines, one request per line: {"ts":<ms since epoch>,"plan":...}
+// where plan is the parsed Graph JSON v1 object or, for legacy text plans,
+// the raw text as a string.
+class CorpusRecorder {
+  constructor(file) {
+    this.file = file;
+    this.stream = fs.createWriteStream(file, { flags: 'a' });
+    this.stream.on('error', (err) => {
+      console.error(`corpus recording to ${file} stopped: ${err.message}`);
+      this.stream = null;
+    });
+    this.recorded = 0;
+  }
+
+  // plan: parsed plan object or raw request text (kept as text unless it is JSON)
+  record(plan) {
+    if (!this.stream) return;
+    if (typeof plan === 'string') {
+      try {
+        const parsed = JSON.parse(plan);
+        if (parsed && typeof parsed === 'object') plan = parsed;
+      } catch (_) {
+        // legacy text plan
+      }
+    }
+    this.stream.write(`${JSON.stringify({ ts: Date.now(), plan })}\n`);
+    this.recorded++;
+  }
+
+  close() {
+    if (this.stream) this.stream.end();
+    this.stream = null;
+  }
+}
+
+// Reads a corpus: { entries: [{ ts, plan }] in file order, skipped } where
+// skipped counts malformed lines.
+function readCorpus(file) {
+  const entries = [];
+  let skipped = 0;
+  for (const line of fs.readFileSync(file, 'utf8').split('\n')) {
+    if (!line.trim()) continue;
+    try {
+      const e = JSON.parse(line);
+      if (e && e.plan !== undefined) entries.push({ ts: Number(e.ts) || 0, plan: e.plan });
+      else skipped++;
+    } catch (_) {
+      skipped++;
+    }
+  }
+  return { entries, skipped };
+}
+
+function writeCorpus(file, plans) {
+  const ts = Date.now();
+  fs.writeFileSync(file, plans.map((plan) => `${JSON.stringify({ ts, plan })}\n`).join(''));
+}
+
+module.exports = { CorpusRecorder, readCorpus, writeCorpus };
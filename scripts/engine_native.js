@@ -0,0 +1,132 @@
+const path = require('path');
+
+// In-process engine binding (scripts/engine_addon.node, built by run.sh).
+// `addon` is null when the addon is missing or fails to load; callers then
+// fall back to the LuaJIT worker pool.
+let addon = null;
+let loadError = null;
+try {
+  addon = require(path.join(__dirname, 'engine_addon.node'));
+} catch (err) {
+  loadError = err;
+}
+
+// Every Graph.run()/runJson()/runBatch() holds one libuv threadpool thread
+// until the engine finishes it (see engine_addon.cc), so `runs` concurrent runs
+// need that many threads on top of the 4 libuv keeps for fs and dns. libuv
+// reads UV_THREADPOOL_SIZE once, when the pool first starts, so call this
+// before any asynchronous I/O. An explicit UV_THREADPOOL_SIZE is left alone.
+function reserveRunThreads(runs) {
+  if (process.env.UV_THREADPOOL_SIZE) return;
+  process.env.UV_THREADPOOL_SIZE = String(Math.min(1024, Math.max(1, runs | 0) + 4));
+}
+
+// Same coercion as run_graph.lua: numeric strings become numbers.
+function paramValue(value) {
+  if (typeof value === 'string' && value.trim() !== '' && !Number.isNaN(Number(value))) return Number(value);
+  return value;
+}
+
+// Describes what is wrong with the shape of a parsed Graph JSON v1 plan
+// (root, nodes, edges.data and outputs must be objects or arrays of objects),
+// or returns null. Callers that walk a plan before building it check this
+// first so a malformed body is a client error, not a TypeError.
+function planShapeError(plan) {
+  if (!plan || typeof plan !== 'object' || Array.isArray(plan)) return 'Invalid JSON: root must be object';
+  const listOfObjects = (v) => v === undefined || (Array.isArray(v) && v.every((x) => x && typeof x === 'object'));
+  if (!listOfObjects(plan.nodes)) return 'Invalid JSON: nodes must be an array of objects';
+  if (plan.edges !== undefined && (!plan.edges || typeof plan.edges !== 'object' || !listOfObjects(plan.edges.data))) {
+    return 'Invalid JSON: edges.data must be an array of objects';
+  }
+  if (!listOfObjects(plan.outputs)) return 'Invalid JSON: outputs must be an array of objects';
+  return null;
+}
+
+// Builds an engine Graph from a parsed Graph JSON v1 plan. Throws an Error
+// whose message matches run_graph.lua's error text.
+function buildGraph(plan) {
+  const shapeError = planShapeError(plan);
+  if (shapeError) throw new Error(shapeError);
+  if (plan.version !== 1) throw new Error(`Unsupported plan version: ${plan.version}`);
+
+  const g = new addon.Graph();
+  try {
+    for (const node of plan.nodes || []) {
+      g.addNode(node.id, node.type);
+      for (const [key, value] of Object.entries(node.params || {})) {
+        g.setParam(node.id, key, paramValue(value));
+      }
+    }
+    for (const e of (plan.edges && plan.edges.data) || []) {
+      g.connect(e.from, e.fromOutput || 0, e.to, e.toInput || 0);
+    }
+    for (const o of plan.outputs || []) {
+      g.addOutput(o.node, o.output || 0);
+    }
+  } catch (err) {
+    g.dispose();
+    throw err;
+  }
+  return g;
+}
+
+// Builds, runs and disposes a graph; resolves to { outputs: [...] }.
+async function runPlan(plan) {
+  const g = buildGraph(plan);
+  try {
+    return { outputs: await g.run() };
+  } finally {
+    g.dispose();
+  }
+}
+
+// Same, but resolves to the engine-rendered '{"outputs":[...]}' document.
+async function runPlanJson(plan) {
+  const g = buildGraph(plan);
+  try {
+    return await g.runJson();
+  } finally {
+    g.dispose();
+  }
+}
+
+// Runs a fresh graph with per-node profiling; resolves to the
+// '{"outputs":[...],"profile":{...}}' document.
+async function runPlanProfiled(plan) {
+  const g = buildGraph(plan);
+  try {
+    g.setProfiling(true);
+    const json = await g.runJson();
+    return `${json.slice(0, -1)},"profile":${g.profile()}}`;
+  } finally {
+    g.dispose();
+  }
+}
+
+// Builds every plan and runs the ones that built as a single engine batch
+// (one combined task graph). Resolves to one entry per plan, in order:
+// { outputs } or { error }.
+async function runBatch(plans) {
+  const results = new Array(plans.length);
+  const graphs = [];
+  const slots = [];
+  for (let i = 0; i < plans.length; i++) {
+    try {
+      graphs.push(buildGraph(plans[i]));
+      slots.push(i);
+    } catch (err) {
+      results[i] = { error: String(err.message || err) };
+    }
+  }
+  try {
+    const ran = graphs.length ? await addon.runBatch(graphs) : [];
+    ran.forEach((r, k) => {
+      results[slots[k]] = r instanceof Error ? { error: r.message } : { outputs: r };
+    });
+  } finally {
+    for (const g of graphs) g.dispose();
+  }
+  return results;
+}
+
+module.exports = { addon, loadError, reserveRunThreads, paramValue, planShapeError, buildGraph, runPlan, runPlanJson, runPlanProfiled, runBatch };
@@ -0,0 +1,146 @@
+const crypto = require('crypto');
+const { addon, buildGraph, paramValue } = require('./engine_native');
+
+// Cache of resident engine graphs keyed by plan topology.
+//
+// The key covers node ids/types, the parameter *names* each node sets, data
+// edges and output pins. Parameter values are not part of the key: on a hit
+// only the values that differ from the previous run are written, and the
+// engine reuses its compiled schedule, so construction, validation and
+// scheduling are skipped.
+//
+// One graph cannot run concurrently, so an entry keeps a small pool of
+// identical graphs: a request takes an idle one, or builds another when all
+// are busy, and returns it afterwards. Entries are evicted least-recently-used
+// once the estimated footprint of all their graphs exceeds the budget. When
+// the engine's catalog version changes (a plugin was loaded), every entry is
+// dropped, since its graphs were built against the old node types.
+const NODE_BYTES = 512; // Node, params map, value buffers, Taskflow task
+const EDGE_BYTES = 96; // Edge + task precedence links
+
+function topologyKey(plan) {
+  const h = crypto.createHash('sha1');
+  for (const n of plan.nodes || []) {
+    h.update(`n${n.id}:${n.type}(${Object.keys(n.params || {}).sort().join(',')})`);
+  }
+  for (const e of (plan.edges && plan.edges.data) || []) {
+    h.update(`e${e.from}.${e.fromOutput || 0}>${e.to}.${e.toInput || 0}`);
+  }
+  for (const o of plan.outputs || []) h.update(`o${o.node}.${o.output || 0}`);
+  return h.digest('hex');
+}
+
+function estimateBytes(plan) {
+  let bytes = 0;
+  for (const n of plan.nodes || []) {
+    bytes += NODE_BYTES;
+    for (const v of Object.values(n.params || {})) bytes += typeof v === 'string' ? v.length : 8;
+  }
+  bytes += ((plan.edges && plan.edges.data) || []).length * EDGE_BYTES;
+  return bytes;
+}
+
+class GraphCache {
+  // catalogVersion: () => current catalog version (default: the addon's).
+  constructor({ budgetBytes, catalogVersion = () => addon.catalogVersion() }) {
+    this.budgetBytes = budgetBytes;
+    this.catalogVersion = catalogVersion;
+    this.version = null;
+    this.bytes = 0;
+    this.entries = new Map(); // key -> entry; Map order doubles as LRU order
+    this.hits = 0;
+    this.misses = 0;
+  }
+
+  // Resolves to { outputs, cached } or rejects with the engine error. With
+  // { json: true } it resolves to { json, cached } instead, json being the
+  // engine-rendered '{"outputs":[...]}' document.
+  async run(plan, { json = false } = {}) {
+    const version = this.catalogVersion();
+    if (version !== this.version) {
+      for (const key of [...this.entries.keys()]) this._drop(key);
+      this.version = version;
+    }
+
+    const key = topologyKey(plan);
+    let entry = this.entries.get(key);
+    if (entry) {
+      this.entries.delete(key); // re-insert as most recent
+      this.entries.set(key, entry);
+    }
+    let inst = entry && entry.idle.pop();
+    const cached = !!inst;
+    if (cached) {
+      this.hits++;
+    } else {
+      this.misses++;
+      // Throws on invalid plans; nothing is cached then
+      inst = { graph: buildGraph(plan), params: new Map() };
+      this._remember(inst, plan);
+      if (!entry) {
+        entry = { key, bytes: estimateBytes(plan), idle: [], busy: 0, dropped: false };
+        this.entries.set(key, entry);
+      }
+      this.bytes += entry.bytes;
+      this._evict();
+    }
+
+    entry.busy++;
+    try {
+      if (cached) this._applyParams(inst, plan);
+      if (json) return { json: await inst.graph.runJson(), cached };
+      return { outputs: await inst.graph.run(), cached };
+    } finally {
+      entry.busy--;
+      if (entry.dropped) inst.graph.dispose();
+      else entry.idle.push(inst);
+    }
+  }
+
+  // Writes only the parameter values that changed since the graph's last run.
+  _applyParams(inst, plan) {
+    for (const n of plan.nodes || []) {
+      const prev = inst.params.get(n.id);
+      for (const [k, raw] of Object.entries(n.params || {})) {
+        const v = paramValue(raw);
+        if (prev[k] !== v) {
+          inst.graph.setParam(n.id, k, v);
+          prev[k] = v;
+        }
+      }
+    }
+  }
+
+  _remember(inst, plan) {
+    for (const n of plan.nodes || []) {
+      const p = {};
+      for (const [k, raw] of Object.entries(n.params || {})) p[k] = paramValue(raw);
+      inst.params.set(n.id, p);
+    }
+  }
+
+  _evict() {
+    for (const key of this.entries.keys()) {
+      if (this.bytes <= this.budgetBytes || this.entries.size <= 1) break;
+      this._drop(key);
+    }
+  }
+
+  // Idle graphs are disposed now, busy ones when their run returns.
+  _drop(key) {
+    const e = this.entries.get(key);
+    this.entries.delete(key);
+    e.dropped = true;
+    this.bytes -= e.bytes * (e.idle.length + e.busy);
+    for (const inst of e.idle) inst.graph.dispose();
+    e.idle = [];
+  }
+
+  stats() {
+    let graphs = 0;
+    for (const e of this.entries.values()) graphs += e.idle.length + e.busy;
+    return { entries: this.entries.size, graphs, bytes: this.bytes, budgetBytes: this.budgetBytes, hits: this.hits, misses: this.misses };
+  }
+}
+
+module.exports = { GraphCache, topologyKey };
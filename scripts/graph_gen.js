@@ -0,0 +1,78 @@
+// Random valid Graph JSON v1 plans built from the engine's type catalog
+// (engine_get_all_type_specs: {"version":..,"types":{name: spec}}).
+//
+// Nodes are added one at a time and every input is wired to a random earlier
+// output of the same socket type, so plans are acyclic and type-correct by
+// construction. Every node that nothing consumes becomes a graph output.
+
+// Small seedable PRNG (mulberry32) so a seed always yields the same corpus.
+function rng(seed) {
+  let a = seed >>> 0;
+  return () => {
+    a = (a + 0x6d2b79f5) >>> 0;
+    let t = a;
+    t = Math.imul(t ^ (t >>> 15), t | 1);
+    t ^= t + Math.imul(t ^ (t >>> 7), t | 61);
+    return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+  };
+}
+
+const WORDS = ['alpha', 'beta', 'gamma', 'delta', 'omega', 'node', 'graph', 'edge', 'tazor', 'light'];
+
+// A random value for a param spec. Free-form strings with a non-empty default
+// (e.g. LuaScript's source) keep the default, since random text would not be
+// a valid program.
+function paramFor(spec, rand) {
+  if (Array.isArray(spec.enum) && spec.enum.length) return spec.enum[Math.floor(rand() * spec.enum.length)];
+  if (spec.type === 'number') return Math.round(rand() * 20000 - 10000) / 100;
+  if (spec.type === 'bool') return rand() < 0.5;
+  if (typeof spec.default === 'string' && spec.default !== '') return spec.default;
+  return WORDS[Math.floor(rand() * WORDS.length)];
+}
+
+// catalog: parsed catalog document. Options:
+//   nodes      node count (default 20)
+//   seed       PRNG seed (default 1)
+//   types      allowlist of type names (default: every type in the catalog)
+//   exclude    type names to leave out
+//   sourceRatio  share of nodes that are sources once others are possible (default 0.2)
+function generateGraph(catalog, { nodes = 20, seed = 1, types = null, exclude = [], sourceRatio = 0.2 } = {}) {
+  const rand = rng(seed);
+  const pick = (arr) => arr[Math.floor(rand() * arr.length)];
+  const specs = Object.values(catalog.types || {}).filter(
+    (s) => (!types || types.includes(s.name)) && !exclude.includes(s.name) && (s.outputs || []).length > 0,
+  );
+  const sources = specs.filter((s) => !(s.inputs || []).length);
+  const inner = specs.filter((s) => (s.inputs || []).length);
+  if (!sources.length) throw new Error('generateGraph: catalog has no source types (no inputs)');
+
+  const producers = new Map(); // socket type -> [{ node, output }]
+  const consumed = new Set();
+  const plan = { version: 1, nodes: [], edges: { data: [], control: [] }, outputs: [] };
+
+  for (let id = 1; id <= nodes; id++) {
+    const wireable = inner.filter((s) => s.inputs.every((t) => producers.has(t)));
+    const spec = !wireable.length || rand() < sourceRatio ? pick(sources) : pick(wireable);
+
+    const params = {};
+    for (const p of spec.params || []) params[p.name] = paramFor(p, rand);
+    plan.nodes.push({ id, type: spec.name, params });
+
+    (spec.inputs || []).forEach((t, toInput) => {
+      const from = pick(producers.get(t));
+      plan.edges.data.push({ from: from.node, fromOutput: from.output, to: id, toInput });
+      consumed.add(from.node);
+    });
+    spec.outputs.forEach((t, output) => {
+      if (!producers.has(t)) producers.set(t, []);
+      producers.get(t).push({ node: id, output });
+    });
+  }
+
+  for (const n of plan.nodes) {
+    if (!consumed.has(n.id)) plan.outputs.push({ node: n.id, output: 0 });
+  }
+  return plan;
+}
+
+module.exports = { generateGraph, rng };
@@ -0,0 +1,203 @@
+const native = require('./engine_native');
+
+// One editor's live graph, driven over the /live WebSocket.
+//
+// The client sends the full plan once ({type:'load'}) and then only deltas:
+//   {type:'param', node, key, value}
+//   {type:'connect' | 'disconnect', from, fromOutput, to, toInput}
+//   {type:'addNode', node: {id, type, params}, output}   output: also add pin (node, 0)
+//   {type:'removeNode', node}                            drops its edges and pins too
+//   {type:'retypeNode', node, nodeType}
+// With the engine addon the graph stays resident: every delta is applied to
+// it in place and the engine recomputes only the affected nodes. Without the
+// addon the session keeps the plan and hands it to `runPlan` on every run.
+//
+// Deltas that arrive while a run is in flight are buffered, and the latest
+// value per (node, key) wins, so a dragged slider costs one run per round trip.
+// Structural deltas are replayed in arrival order. If the engine rejects one
+// (a cycle, say), it is undone in the plan as well and the graph is rebuilt
+// from the plan on the next run.
+class LiveSession {
+  constructor({ runPlan }) {
+    this.runPlan = runPlan; // fallback: async (plan) => { outputs }
+    this.plan = null;
+    this.graph = null;
+    this.rebuild = false;
+    this.pendingParams = new Map(); // "node\0key" -> { node, key, value }
+    this.pendingEdits = []; // [{ apply(graph), undo() }] in arrival order
+    this.lastOutputs = [];
+  }
+
+  load(plan) {
+    if (!plan || typeof plan !== 'object' || Array.isArray(plan)) throw new Error('Invalid JSON: root must be object');
+    if (plan.version !== 1) throw new Error(`Unsupported plan version: ${plan.version}`);
+    this.plan = plan;
+    this.rebuild = true;
+    this.pendingParams.clear();
+    this.pendingEdits = [];
+    this.lastOutputs = [];
+  }
+
+  setParam(node, key, value) {
+    const n = this._node(node);
+    if (!n.params) n.params = {};
+    n.params[key] = value;
+    this.pendingParams.set(`${node}\0${key}`, { node, key, value: native.paramValue(value) });
+  }
+
+  connect(edge) {
+    const e = { from: edge.from, fromOutput: edge.fromOutput || 0, to: edge.to, toInput: edge.toInput || 0 };
+    const data = this._edges();
+    data.push(e);
+    this.pendingEdits.push({
+      apply: (g) => g.connect(e.from, e.fromOutput, e.to, e.toInput),
+      undo: () => { const i = data.lastIndexOf(e); if (i >= 0) data.splice(i, 1); },
+    });
+  }
+
+  disconnect(edge) {
+    const e = { from: edge.from, fromOutput: edge.fromOutput || 0, to: edge.to, toInput: edge.toInput || 0 };
+    const data = this._edges();
+    const i = this._findEdge(e);
+    if (i < 0) throw new Error(`disconnect: no edge ${e.from}.${e.fromOutput} -> ${e.to}.${e.toInput}`);
+    data.splice(i, 1);
+    this.pendingEdits.push({ apply: (g) => g.disconnect(e.from, e.fromOutput, e.to, e.toInput), undo: () => {} });
+  }
+
+  // Returns true if the output pins changed (their indices may have moved).
+  addNode(node, { output = false } = {}) {
+    if (!node || typeof node !== 'object' || typeof node.id !== 'number' || typeof node.type !== 'string') {
+      throw new Error('addNode: node must be {id: number, type: string, params?}');
+    }
+    if (!this.plan) throw new Error('no graph loaded');
+    if (!this.plan.nodes) this.plan.nodes = [];
+    if (this.plan.nodes.some((x) => x.id === node.id)) throw new Error(`addNode: duplicate id ${node.id}`);
+    const n = { id: node.id, type: node.type, params: { ...(node.params || {}) } };
+    this.plan.nodes.push(n);
+    if (output) {
+      if (!this.plan.outputs) this.plan.outputs = [];
+      this.plan.outputs.push({ node: n.id, output: 0 });
+      this.lastOutputs = [];
+    }
+    this.pendingEdits.push({
+      apply: (g) => {
+        g.addNode(n.id, n.type);
+        for (const [key, value] of Object.entries(n.params)) g.setParam(n.id, key, native.paramValue(value));
+        if (output) g.addOutput(n.id, 0);
+      },
+      undo: () => {
+        this.plan.nodes.splice(this.plan.nodes.indexOf(n), 1);
+        if (output) this.plan.outputs = this.plan.outputs.filter((o) => o.node !== n.id);
+      },
+    });
+    return output;
+  }
+
+  // Returns true if the output pins changed.
+  removeNode(id) {
+    const n = this._node(id);
+    this.plan.nodes.splice(this.plan.nodes.indexOf(n), 1);
+    const data = this._edges();
+    this.plan.edges.data = data.filter((e) => e.from !== id && e.to !== id);
+    const pins = (this.plan.outputs || []).length;
+    if (pins) this.plan.outputs = this.plan.outputs.filter((o) => o.node !== id);
+    const pinsChanged = pins !== (this.plan.outputs || []).length;
+    if (pinsChanged) this.lastOutputs = [];
+    for (const k of [...this.pendingParams.keys()]) if (this.pendingParams.get(k).node === id) this.pendingParams.delete(k);
+    this.pendingEdits.push({ apply: (g) => g.removeNode(id), undo: () => {} });
+    return pinsChanged;
+  }
+
+  retypeNode(id, type) {
+    if (typeof type !== 'string') throw new Error('retypeNode: nodeType must be a string');
+    const n = this._node(id);
+    const previous = n.type;
+    n.type = type;
+    this.pendingEdits.push({ apply: (g) => g.retypeNode(id, type), undo: () => { n.type = previous; } });
+  }
+
+  get dirty() {
+    return !!this.plan && (this.rebuild || this.pendingParams.size > 0 || this.pendingEdits.length > 0);
+  }
+
+  // Runs with everything applied so far; resolves to the outputs whose value
+  // or type differs from the previous run ([{index, type, value}]).
+  async run() {
+    if (!this.plan) throw new Error('no graph loaded');
+    let outputs;
+    if (!native.addon) {
+      this.rebuild = false;
+      this.pendingParams.clear();
+      this.pendingEdits = [];
+      outputs = (await this.runPlan(this.plan)).outputs;
+    } else {
+      const params = [...this.pendingParams.values()];
+      const edits = this.pendingEdits;
+      this.pendingParams.clear();
+      this.pendingEdits = [];
+      if (!this.rebuild && this.graph) this._applyEdits(edits);
+      // No graph means the last build failed; the plan carries every edit since
+      if (this.rebuild || !this.graph) {
+        this.rebuild = false;
+        if (this.graph) this.graph.dispose();
+        this.graph = null;
+        this.graph = native.buildGraph(this.plan); // plan already carries the params
+      } else {
+        for (const p of params) this.graph.setParam(p.node, p.key, p.value);
+      }
+      outputs = await this.graph.run();
+    }
+
+    const changed = outputs.filter((o, i) => {
+      const prev = this.lastOutputs[i];
+      return !prev || prev.type !== o.type || prev.value !== o.value;
+    });
+    this.lastOutputs = outputs;
+    return changed;
+  }
+
+  close() {
+    if (this.graph) this.graph.dispose();
+    this.graph = null;
+    this.plan = null;
+  }
+
+  // Replays structural deltas on the resident graph. A rejected delta is
+  // undone in the plan too, the rest of the batch is left to the rebuild, and
+  // the error is rethrown.
+  _applyEdits(edits) {
+    for (const edit of edits) {
+      try {
+        edit.apply(this.graph);
+      } catch (err) {
+        edit.undo();
+        this.rebuild = true;
+        throw err;
+      }
+    }
+  }
+
+  _findEdge(e) {
+    const data = this._edges();
+    for (let i = data.length - 1; i >= 0; i--) {
+      const d = data[i];
+      if (d.from === e.from && (d.fromOutput || 0) === e.fromOutput && d.to === e.to && (d.toInput || 0) === e.toInput) return i;
+    }
+    return -1;
+  }
+
+  _node(id) {
+    const n = this.plan && (this.plan.nodes || []).find((x) => x.id === id);
+    if (!n) throw new Error(`unknown node ${id}`);
+    return n;
+  }
+
+  _edges() {
+    if (!this.plan) throw new Error('no graph loaded');
+    if (!this.plan.edges) this.plan.edges = { data: [], control: [] };
+    if (!this.plan.edges.data) this.plan.edges.data = [];
+    return this.plan.edges.data;
+  }
+}
+
+module.exports = { LiveSession };
@@ -1,4 +1,5 @@
 local ffi = require('ffi')
+local bit = require('bit')
 
 ffi.cdef[[
 typedef void* engine_graph_t;
@@ -23,8 +24,15 @@ eng_type_t engine_graph_get_output_type (engine_graph_t g, int index);
 int        engine_graph_get_output_number(engine_graph_t g, int index, double* out);
 int        engine_graph_get_output_bool  (engine_graph_t g, int index, int* out);
 const char* engine_graph_get_output_string(engine_graph_t g, int index);
+const char* engine_graph_outputs_json(engine_graph_t g, size_t* len);
+int         engine_graph_set_profiling(engine_graph_t g, int enabled);
+const char* engine_graph_get_profile_json(engine_graph_t g);
 
 const char* engine_last_error(void);
+
+const char* engine_list_types(void);
+const char* engine_get_type_spec(const char* typeName);
+const char* engine_get_all_type_specs(void);
 ]]
 
 local function json_escape(s)
@@ -33,132 +41,215 @@ local function json_escape(s)
   return s
 end
 
--- Minimal JSON parser for our specific Graph JSON v1 format
-local function parse_json(json_str)
-  local trimmed = json_str:match("^%s*(.-)%s*$")
-  if not trimmed:match("^%s*{") then
-    return nil -- Not JSON
+-- ========= JSON =========
+--
+-- Single-pass parser over the raw bytes (FFI pointer access, string.find for
+-- runs of plain characters). Handles the full JSON grammar: string escapes
+-- including \uXXXX surrogate pairs, exponents, true/false/null, nesting.
+-- Errors are raised as { json = "message" } and caught by the caller.
+local band, bor, rshift = bit.band, bit.bor, bit.rshift
+local sfind, ssub, schar = string.find, string.sub, string.char
+
+local json_null = setmetatable({}, { __tostring = function() return "null" end })
+
+local src, buf, len, pos  -- pos: 0-based offset into buf
+
+local function json_fail(msg)
+  error({ json = string.format("Invalid JSON at byte %d: %s", pos + 1, msg) }, 0)
+end
+
+local function skip_ws()
+  while pos < len do
+    local c = buf[pos]
+    if c ~= 32 and c ~= 9 and c ~= 10 and c ~= 13 then return c end
+    pos = pos + 1
   end
-  
-  -- Simple recursive descent parser for our specific JSON structure
-  local pos = 1
-  local len = #trimmed
-  
-  local function skip_whitespace()
-    while pos <= len and trimmed:sub(pos, pos):match("%s") do
-      pos = pos + 1
-    end
+  return nil
+end
+
+local function expect(c, what)
+  if skip_ws() ~= c then json_fail("expected " .. what) end
+  pos = pos + 1
+end
+
+local function utf8_char(cp)
+  if cp < 0x80 then return schar(cp) end
+  if cp < 0x800 then return schar(bor(0xC0, rshift(cp, 6)), bor(0x80, band(cp, 0x3F))) end
+  if cp < 0x10000 then
+    return schar(bor(0xE0, rshift(cp, 12)), bor(0x80, band(rshift(cp, 6), 0x3F)), bor(0x80, band(cp, 0x3F)))
   end
-  
-  local function parse_value()
-    skip_whitespace()
-    if pos > len then return nil end
-    
-    local char = trimmed:sub(pos, pos)
-    
-    if char == '"' then
-      -- Parse string
-      pos = pos + 1
-      local start = pos
-      while pos <= len and trimmed:sub(pos, pos) ~= '"' do
-        pos = pos + 1
-      end
-      if pos > len then return nil end
-      local str = trimmed:sub(start, pos - 1)
-      pos = pos + 1
-      return str
-    elseif char == '{' then
-      -- Parse object
-      pos = pos + 1
-      local obj = {}
-      skip_whitespace()
-      if pos <= len and trimmed:sub(pos, pos) == '}' then
-        pos = pos + 1
-        return obj
-      end
-      
-      while pos <= len do
-        skip_whitespace()
-        -- Parse key
-        if trimmed:sub(pos, pos) ~= '"' then return nil end
-        local key = parse_value()
-        if not key then return nil end
-        
-        skip_whitespace()
-        if pos > len or trimmed:sub(pos, pos) ~= ':' then return nil end
-        pos = pos + 1
-        
-        -- Parse value
-        local value = parse_value()
-        if value == nil then return nil end
-        obj[key] = value
-        
-        skip_whitespace()
-        if pos > len then return nil end
-        
-        if trimmed:sub(pos, pos) == '}' then
-          pos = pos + 1
-          return obj
-        elseif trimmed:sub(pos, pos) == ',' then
-          pos = pos + 1
-        else
-          return nil
-        end
-      end
-      return nil
-    elseif char == '[' then
-      -- Parse array
-      pos = pos + 1
-      local arr = {}
-      skip_whitespace()
-      if pos <= len and trimmed:sub(pos, pos) == ']' then
-        pos = pos + 1
-        return arr
-      end
-      
-      while pos <= len do
-        local value = parse_value()
-        if value == nil then return nil end
-        table.insert(arr, value)
-        
-        skip_whitespace()
-        if pos > len then return nil end
-        
-        if trimmed:sub(pos, pos) == ']' then
-          pos = pos + 1
-          return arr
-        elseif trimmed:sub(pos, pos) == ',' then
-          pos = pos + 1
+  return schar(bor(0xF0, rshift(cp, 18)), bor(0x80, band(rshift(cp, 12), 0x3F)),
+               bor(0x80, band(rshift(cp, 6), 0x3F)), bor(0x80, band(cp, 0x3F)))
+end
+
+local escapes = { [34] = '"', [92] = '\\', [47] = '/', [98] = '\b', [102] = '\f', [110] = '\n', [114] = '\r', [116] = '\t' }
+
+local function read_hex4()
+  local h = ssub(src, pos + 1, pos + 4)
+  local v = #h == 4 and h:find("^%x%x%x%x$") and tonumber(h, 16)
+  if not v then json_fail("bad \\u escape") end
+  pos = pos + 4
+  return v
+end
+
+local function parse_string()
+  pos = pos + 1  -- opening quote
+  local start = pos
+  -- fast path: no escapes
+  local q = sfind(src, '["\\]', pos + 1)
+  if not q then json_fail("unterminated string") end
+  if buf[q - 1] == 34 then
+    pos = q
+    return ssub(src, start + 1, q - 1)
+  end
+  local parts, n = {}, 0
+  while true do
+    q = sfind(src, '["\\]', pos + 1)
+    if not q then json_fail("unterminated string") end
+    if q - 1 > pos then n = n + 1; parts[n] = ssub(src, pos + 1, q - 1) end
+    pos = q  -- now at quote/backslash + 1 (1-based q == 0-based pos of next char)
+    if buf[q - 1] == 34 then break end
+    local e = buf[pos]
+    pos = pos + 1
+    local r = escapes[e]
+    if r then
+      n = n + 1; parts[n] = r
+    elseif e == 117 then  -- \u
+      local cp = read_hex4()
+      if cp >= 0xD800 and cp <= 0xDBFF and buf[pos] == 92 and buf[pos + 1] == 117 then
+        pos = pos + 2
+        local lo = read_hex4()
+        if lo >= 0xDC00 and lo <= 0xDFFF then
+          cp = 0x10000 + (cp - 0xD800) * 0x400 + (lo - 0xDC00)
         else
-          return nil
+          n = n + 1; parts[n] = utf8_char(cp)
+          cp = lo
         end
       end
-      return nil
-    elseif char:match("[%d%-]") then
-      -- Parse number
-      local start = pos
-      if char == '-' then pos = pos + 1 end
-      while pos <= len and trimmed:sub(pos, pos):match("[%d%.]") do
-        pos = pos + 1
-      end
-      local num_str = trimmed:sub(start, pos - 1)
-      return tonumber(num_str)
-    elseif trimmed:sub(pos, pos + 3) == "true" then
-      pos = pos + 4
-      return true
-    elseif trimmed:sub(pos, pos + 4) == "false" then
-      pos = pos + 5
-      return false
-    elseif trimmed:sub(pos, pos + 3) == "null" then
-      pos = pos + 4
-      return nil
+      n = n + 1; parts[n] = utf8_char(cp)
+    else
+      json_fail("bad escape")
     end
-    
-    return nil
   end
-  
-  return parse_value()
+  return table.concat(parts, "", 1, n)
+end
+
+local function parse_number()
+  local s, e = sfind(src, "^-?%d+", pos + 1)
+  if not s then json_fail("bad number") end
+  local _, e2 = sfind(src, "^%.%d+", e + 1)
+  if e2 then e = e2 end
+  _, e2 = sfind(src, "^[eE][-+]?%d+", e + 1)
+  if e2 then e = e2 end
+  local v = tonumber(ssub(src, s, e))
+  pos = e
+  return v
+end
+
+local parse_value
+
+local function parse_array()
+  pos = pos + 1
+  local arr, n = {}, 0
+  if skip_ws() == 93 then pos = pos + 1; return arr end
+  while true do
+    n = n + 1
+    arr[n] = parse_value()
+    local c = skip_ws()
+    pos = pos + 1
+    if c == 93 then return arr end
+    if c ~= 44 then pos = pos - 1; json_fail("expected ',' or ']'") end
+  end
+end
+
+local function parse_object()
+  pos = pos + 1
+  local obj = {}
+  if skip_ws() == 125 then pos = pos + 1; return obj end
+  while true do
+    if skip_ws() ~= 34 then json_fail("expected object key") end
+    local k = parse_string()
+    expect(58, "':'")
+    obj[k] = parse_value()
+    local c = skip_ws()
+    pos = pos + 1
+    if c == 125 then return obj end
+    if c ~= 44 then pos = pos - 1; json_fail("expected ',' or '}'") end
+  end
+end
+
+-- null decodes to json_null so it survives as a table/array element
+function parse_value()
+  local c = skip_ws()
+  if c == 34 then return parse_string()
+  elseif c == 123 then return parse_object()
+  elseif c == 91 then return parse_array()
+  elseif c == 45 or (c and c >= 48 and c <= 57) then return parse_number()
+  elseif c == 116 and ssub(src, pos + 1, pos + 4) == "true" then pos = pos + 4; return true
+  elseif c == 102 and ssub(src, pos + 1, pos + 5) == "false" then pos = pos + 5; return false
+  elseif c == 110 and ssub(src, pos + 1, pos + 4) == "null" then pos = pos + 4; return json_null
+  end
+  json_fail(c and "unexpected character" or "unexpected end of input")
+end
+
+-- Iterates the members of the object at pos: on_member(key) must consume the value.
+local function each_member(on_member)
+  expect(123, "'{'")
+  if skip_ws() == 125 then pos = pos + 1; return end
+  while true do
+    if skip_ws() ~= 34 then json_fail("expected object key") end
+    local k = parse_string()
+    expect(58, "':'")
+    on_member(k)
+    local c = skip_ws()
+    pos = pos + 1
+    if c == 125 then return end
+    if c ~= 44 then pos = pos - 1; json_fail("expected ',' or '}'") end
+  end
+end
+
+-- Iterates the elements of the array at pos, handing each decoded element to on_item.
+local function each_item(on_item)
+  expect(91, "'['")
+  if skip_ws() == 93 then pos = pos + 1; return end
+  while true do
+    on_item(parse_value())
+    local c = skip_ws()
+    pos = pos + 1
+    if c == 93 then return end
+    if c ~= 44 then pos = pos - 1; json_fail("expected ',' or ']'") end
+  end
+end
+
+-- Streams a Graph JSON v1 document into handlers without materializing it:
+-- only one node/edge/output object exists at a time.
+--   handlers.version(v), handlers.node(n), handlers.edge(e), handlers.output(o)
+local function stream_plan(text, handlers)
+  src, len, pos = text, #text, 0
+  buf = ffi.cast("const uint8_t*", text)
+  each_member(function(key)
+    if key == "version" then
+      handlers.version(parse_value())
+    elseif key == "nodes" then
+      each_item(handlers.node)
+    elseif key == "outputs" then
+      each_item(handlers.output)
+    elseif key == "edges" then
+      each_member(function(kind)
+        if kind == "data" then each_item(handlers.edge) else parse_value() end
+      end)
+    else
+      parse_value()
+    end
+  end)
+  if skip_ws() then json_fail("trailing characters") end
+  src, buf = nil, nil
 end
+
+-- Errors are collected here; the one-shot CLI prints it to stderr, the worker
+-- loop sends it back as an error frame.
+local last_error = nil
+
 local function err_json(msg, tried, errs)
   local extra = ""
   if tried and #tried > 0 then
@@ -167,7 +258,7 @@ local function err_json(msg, tried, errs)
       extra = extra .. ', "errors": ["' .. table.concat(errs, '","'):gsub('\n',' ') .. '"]'
     end
   end
-  io.stderr:write(string.format('{"error":"%s%s"}\n', json_escape(msg), extra))
+  last_error = string.format('{"error":"%s%s"}', json_escape(msg), extra)
 end
 
 local function dirname(p) return (p and p:match("^(.*)/[^/]+$")) or "." end
@@ -191,6 +282,7 @@ if not lib then lib = try_load("scripts/lua/../../libengine.so") end          --
 
 if not lib then
   err_json("failed to load libengine.so", tried, errors)
+  io.stderr:write(last_error, "\n")
   os.exit(1)
 end
 
@@ -199,73 +291,69 @@ local function read_all_stdin()
   return all or ""
 end
 
-local function parse_json_plan(g, data, ensure_ok)
-  -- Validate JSON structure
-  if type(data) ~= "table" then
-    err_json("Invalid JSON: root must be object")
-    lib.engine_graph_destroy(g)
-    return nil
+-- Builds the graph while the plan streams in. Edges/outputs that arrive before
+-- the nodes array has been seen are held back until the end.
+local function parse_json_plan(g, plan, ensure_ok)
+  local version
+  local nodes_seen = false
+  local deferred = {}
+  local aborted = false
+
+  local function check(rc, ctx)
+    if not ensure_ok(rc, ctx) then aborted = true; error({ engine = true }, 0) end
   end
-  
-  if data.version ~= 1 then
-    err_json("Unsupported plan version: " .. tostring(data.version))
-    lib.engine_graph_destroy(g)
-    return nil
+
+  local function add_edge(edge)
+    check(lib.engine_graph_connect(g, edge.from, edge.fromOutput or 0, edge.to, edge.toInput or 0), "connect")
   end
-  
-  local nodes = data.nodes or {}
-  local edges = data.edges or {}
-  local dataEdges = edges.data or {}
-  local outputs = data.outputs or {}
-  
-  -- Add nodes
-  for _, node in ipairs(nodes) do
-    local id = node.id
-    local nodeType = node.type
-    local params = node.params or {}
-    
-    if not ensure_ok(lib.engine_graph_add_node_with_id(g, id, nodeType, nil), "add_node "..nodeType) then 
-      return nil 
-    end
-    
-    -- Set parameters
-    for key, value in pairs(params) do
-      local num = tonumber(value)
-      if num then
-        if not ensure_ok(lib.engine_graph_set_param_number(g, id, key, num), "set_param_number "..key) then 
-          return nil 
-        end
-      else
-        if not ensure_ok(lib.engine_graph_set_param_string(g, id, key, tostring(value)), "set_param_string "..key) then 
-          return nil 
+  local function add_output(output)
+    check(lib.engine_graph_add_output(g, output.node, output.output or 0), "add_output")
+  end
+
+  local handlers = {
+    version = function(v)
+      version = v
+      if v ~= 1 then error({ json = "Unsupported plan version: " .. tostring(v) }, 0) end
+    end,
+    node = function(node)
+      local id = node.id
+      local nodeType = node.type
+      if type(id) ~= "number" or type(nodeType) ~= "string" then
+        error({ json = "node requires numeric 'id' and string 'type'" }, 0)
+      end
+      check(lib.engine_graph_add_node_with_id(g, id, nodeType, nil), "add_node " .. tostring(nodeType))
+      if type(node.params) == "table" then
+        for key, value in pairs(node.params) do
+          local num = tonumber(value)
+          if num then
+            check(lib.engine_graph_set_param_number(g, id, key, num), "set_param_number " .. key)
+          elseif value ~= json_null then
+            check(lib.engine_graph_set_param_string(g, id, key, tostring(value)), "set_param_string " .. key)
+          end
         end
       end
-    end
-  end
-  
-  -- Add connections
-  for _, edge in ipairs(dataEdges) do
-    local fromNode = edge.from or edge["from"]
-    local fromOutput = edge.fromOutput or edge["fromOutput"] or 0
-    local toNode = edge.to or edge["to"]
-    local toInput = edge.toInput or edge["toInput"] or 0
-    
-    if not ensure_ok(lib.engine_graph_connect(g, fromNode, fromOutput, toNode, toInput), "connect") then 
-      return nil 
-    end
-  end
-  
-  -- Add outputs
-  for _, output in ipairs(outputs) do
-    local nodeId = output.node or output["node"]
-    local outputIdx = output.output or output["output"] or 0
-    
-    if not ensure_ok(lib.engine_graph_add_output(g, nodeId, outputIdx), "add_output") then 
-      return nil 
-    end
-  end
-  
-  return g
+      nodes_seen = true
+    end,
+    edge = function(edge)
+      if nodes_seen then add_edge(edge) else deferred[#deferred + 1] = { add_edge, edge } end
+    end,
+    output = function(output)
+      if nodes_seen then add_output(output) else deferred[#deferred + 1] = { add_output, output } end
+    end,
+  }
+
+  local ok, e = pcall(function()
+    stream_plan(plan, handlers)
+    if version ~= 1 then error({ json = "Unsupported plan version: " .. tostring(version) }, 0) end
+    for _, d in ipairs(deferred) do d[1](d[2]) end
+  end)
+  if ok then return g end
+
+  src, buf = nil, nil
+  if aborted then return nil end  -- ensure_ok already reported and destroyed g
+  lib.engine_graph_destroy(g)
+  if type(e) == "table" and e.json then err_json(e.json) else err_json(tostring(e)) end
+  return nil
 end
 
 local function parse_text_plan(g, plan, ensure_ok)
@@ -328,53 +416,127 @@ local function parse_and_build(plan)
     return true
   end
 
-  -- Try to parse as JSON first
-  local json_data, json_err = parse_json(plan)
-  if json_data then
-    return parse_json_plan(g, json_data, ensure_ok)
+  -- JSON v1 if the document starts with an object, legacy text format otherwise
+  if plan:find("^%s*{") then
+    return parse_json_plan(g, plan, ensure_ok)
   end
-  
-  -- Fall back to text format
   return parse_text_plan(g, plan, ensure_ok)
 end
 
-local function run_and_emit_json(g)
+local out_len = ffi.new("size_t[1]")
+
+-- Runs the graph and returns the {"outputs":[...]} document, or nil on error.
+-- With `profile` the document also carries the run's "profile".
+-- The graph is always destroyed.
+local function run_and_collect_json(g, profile)
+  if profile then lib.engine_graph_set_profiling(g, 1) end
   local rc = lib.engine_graph_run(g)
   if rc ~= 0 then
     local cstr = lib.engine_last_error()
     local msg = cstr ~= nil and ffi.string(cstr) or "run failed"
     err_json(msg)
     lib.engine_graph_destroy(g)
-    return false
+    return nil
   end
 
-  local count = lib.engine_graph_get_output_count(g)
-  io.write('{"outputs":[')
-  for i = 0, count - 1 do
-    if i > 0 then io.write(',') end
-    local t = lib.engine_graph_get_output_type(g, i)
-    if t == ffi.C.ENG_TYPE_NUMBER then
-      local out = ffi.new("double[1]")
-      lib.engine_graph_get_output_number(g, i, out)
-      io.write(string.format('{"index":%d,"type":"number","value":%s}', i, tostring(out[0])))
-    elseif t == ffi.C.ENG_TYPE_STRING then
-      local s = lib.engine_graph_get_output_string(g, i)
-      local str = s ~= nil and ffi.string(s) or ""
-      io.write(string.format('{"index":%d,"type":"string","value":"%s"}', i, json_escape(str)))
-    elseif t == ffi.C.ENG_TYPE_BOOL then
-      local out = ffi.new("int[1]")
-      lib.engine_graph_get_output_bool(g, i, out)
-      io.write(string.format('{"index":%d,"type":"bool","value":%s}', i, (out[0] ~= 0) and "true" or "false"))
-    else
-      io.write(string.format('{"index":%d,"type":"unknown"}', i))
-    end
+  -- Rendered by the engine in one call; copy out before the graph goes away
+  local json = lib.engine_graph_outputs_json(g, out_len)
+  local result = json ~= nil and ffi.string(json, out_len[0]) or '{"outputs":[]}'
+  if profile then
+    result = result:sub(1, -2) .. ',"profile":' .. ffi.string(lib.engine_graph_get_profile_json(g)) .. '}'
   end
-  io.write("]}\n")
   lib.engine_graph_destroy(g)
-  return true
+  return result
 end
 
+local function engine_string(cstr, what)
+  if cstr == nil then
+    local e = lib.engine_last_error()
+    err_json(e ~= nil and ffi.string(e) or (what .. " failed"))
+    return nil
+  end
+  return ffi.string(cstr)
+end
+
+-- ========= worker mode =========
+--
+-- `luajit run_graph.lua --worker` serves requests until stdin closes, so the
+-- server pays process startup, ffi.load and registry construction once.
+--
+-- Frames in both directions: 4-byte big-endian payload length, then payload.
+--   request payload:  <op byte><body>
+--     R <plan>        run a plan (JSON v1 or text)
+--     P <plan>        same, with the per-node profile in the result
+--     L               engine_list_types
+--     T <typeName>    engine_get_type_spec
+--     C               engine_get_all_type_specs
+--   response payload: <'0' ok | '1' error><JSON>
+
+local function read_frame()
+  local hdr = io.read(4)
+  if not hdr or #hdr < 4 then return nil end
+  local b1, b2, b3, b4 = hdr:byte(1, 4)
+  local n = ((b1 * 256 + b2) * 256 + b3) * 256 + b4
+  if n == 0 then return "" end
+  local payload = io.read(n)
+  if not payload or #payload < n then return nil end
+  return payload
+end
+
+local function write_frame(status, body)
+  local n = #body + 1
+  io.write(string.char(bit.band(bit.rshift(n, 24), 255), bit.band(bit.rshift(n, 16), 255),
+                       bit.band(bit.rshift(n, 8), 255), bit.band(n, 255)), status, body)
+  io.flush()
+end
+
+local function handle(op, body)
+  last_error = nil
+  local result
+  if op == "R" or op == "P" then
+    local g = parse_and_build(body)
+    if g then result = run_and_collect_json(g, op == "P") end
+  elseif op == "L" then
+    result = engine_string(lib.engine_list_types(), "engine_list_types")
+  elseif op == "T" then
+    result = engine_string(lib.engine_get_type_spec(body), "engine_get_type_spec")
+  elseif op == "C" then
+    result = engine_string(lib.engine_get_all_type_specs(), "engine_get_all_type_specs")
+  else
+    err_json("unknown op '" .. op .. "'")
+  end
+  if result then return "0", result end
+  return "1", last_error or '{"error":"request failed"}'
+end
+
+local function serve()
+  io.stdout:setvbuf("full")
+  while true do
+    local payload = read_frame()
+    if not payload then return end
+    local ok, status, result = pcall(handle, payload:sub(1, 1), payload:sub(2))
+    if not ok then
+      status, result = "1", string.format('{"error":"%s"}', json_escape(status))
+    end
+    write_frame(status, result)
+  end
+end
+
+if arg and arg[1] == "--worker" then
+  serve()
+  os.exit(0)
+end
+
+-- ========= one-shot mode: plan on stdin, result on stdout =========
 local plan = read_all_stdin()
 local g = parse_and_build(plan)
-if not g then os.exit(2) end
-if not run_and_emit_json(g) then os.exit(3) end
+if not g then
+  io.stderr:write(last_error or '{"error":"failed to build graph"}', "\n")
+  os.exit(2)
+end
+local out = run_and_collect_json(g)
+if not out then
+  io.stderr:write(last_error or '{"error":"run failed"}', "\n")
+  os.exit(3)
+end
+io.write(out, "\n")
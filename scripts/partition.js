@@ -0,0 +1,107 @@
+// K-way partitioning of Graph JSON v1 plans for sharded execution (see
+// shard_coordinator.js).
+//
+// Shards are kept monotone: for every edge u -> v, shard(u) <= shard(v). The
+// shards then form a DAG themselves, so each one can run as soon as the
+// shards before it have delivered their boundary values, and no shard ever
+// waits on itself.
+//
+//   1. Topological order preferring depth first (Kahn with a LIFO ready set),
+//      which keeps chains and subtrees next to each other.
+//   2. Split that order into k contiguous runs of about total/k cost.
+//   3. Refine: move nodes on a shard boundary into the neighbouring shard
+//      when that cuts fewer edges, stays monotone and keeps every shard within
+//      the imbalance tolerance (a Fiduccia-Mattheyses style pass restricted
+//      to positive-gain moves), until a pass finds nothing to move.
+
+// plan: parsed Graph JSON v1. Options:
+//   cost       (node) => relative cost (default 1 per node)
+//   imbalance  allowed load above the average, as a fraction (default 0.1)
+//   passes     refinement pass limit (default 8)
+// Returns { shardOf: Map(node id -> shard), shards: [[node id, ...], ...],
+//           loads: [cost per shard], cutEdges }.
+function partitionPlan(plan, k, { cost = () => 1, imbalance = 0.1, passes = 8 } = {}) {
+  const nodes = plan.nodes || [];
+  const edges = (plan.edges && plan.edges.data) || [];
+  k = Math.max(1, Math.min(k | 0, nodes.length || 1));
+
+  const index = new Map(nodes.map((n, i) => [n.id, i]));
+  const succ = nodes.map(() => []);
+  const pred = nodes.map(() => []);
+  const indeg = new Int32Array(nodes.length);
+  for (const e of edges) {
+    const a = index.get(e.from);
+    const b = index.get(e.to);
+    if (a === undefined || b === undefined) throw new Error(`partition: edge ${e.from} -> ${e.to} names an unknown node`);
+    succ[a].push(b);
+    pred[b].push(a);
+    indeg[b]++;
+  }
+
+  // 1. Depth-first-leaning topological order
+  const order = [];
+  const ready = [];
+  for (let i = nodes.length - 1; i >= 0; i--) if (indeg[i] === 0) ready.push(i);
+  while (ready.length) {
+    const u = ready.pop();
+    order.push(u);
+    for (let j = succ[u].length - 1; j >= 0; j--) if (--indeg[succ[u][j]] === 0) ready.push(succ[u][j]);
+  }
+  if (order.length !== nodes.length) throw new Error('partition: Cycle detected in graph');
+
+  // 2. Contiguous split by cost
+  const w = nodes.map((n) => Math.max(0, Number(cost(n)) || 0));
+  const total = w.reduce((a, b) => a + b, 0);
+  const shard = new Int32Array(nodes.length);
+  const loads = new Array(k).fill(0);
+  let s = 0;
+  let done = 0;
+  for (let i = 0; i < order.length; i++) {
+    const u = order[i];
+    // Advance once this shard has its share, leaving at least one node per remaining shard
+    if (s < k - 1 && loads[s] > 0 && (done + w[u] / 2 > (total * (s + 1)) / k || order.length - i <= k - 1 - s)) s++;
+    shard[u] = s;
+    loads[s] += w[u];
+    done += w[u];
+  }
+
+  // 3. Boundary refinement
+  const cap = (total / k) * (1 + imbalance);
+  const sizes = new Int32Array(k);
+  for (let u = 0; u < nodes.length; u++) sizes[shard[u]]++;
+  for (let pass = 0; pass < passes; pass++) {
+    let moved = 0;
+    for (const u of order) {
+      const from = shard[u];
+      for (const to of [from - 1, from + 1]) {
+        if (to < 0 || to >= k || sizes[from] <= 1 || loads[to] + w[u] > cap) continue;
+        // Monotone: moving down needs every producer at or below `to`, moving up every consumer at or above
+        if (to < from ? pred[u].some((p) => shard[p] > to) : succ[u].some((c) => shard[c] < to)) continue;
+        let gain = 0;
+        for (const x of pred[u]) gain += (shard[x] === to) - (shard[x] === from);
+        for (const x of succ[u]) gain += (shard[x] === to) - (shard[x] === from);
+        if (gain <= 0) continue;
+        shard[u] = to;
+        loads[from] -= w[u];
+        loads[to] += w[u];
+        sizes[from]--;
+        sizes[to]++;
+        moved++;
+        break;
+      }
+    }
+    if (!moved) break;
+  }
+
+  const shardOf = new Map();
+  const shards = Array.from({ length: k }, () => []);
+  for (const u of order) {
+    shardOf.set(nodes[u].id, shard[u]);
+    shards[shard[u]].push(nodes[u].id);
+  }
+  let cutEdges = 0;
+  for (const e of edges) if (shardOf.get(e.from) !== shardOf.get(e.to)) cutEdges++;
+  return { shardOf, shards, loads, cutEdges };
+}
+
+module.exports = { partitionPlan };
@@ -88,6 +88,7 @@
       
       let template, inputHandler;
       const initial = this.getInitialValue();
+      const ctrl = this;
       
       if (paramSpec.type === 'number') {
         template = `<input type="number" :value="getData(ikey) ?? ${initial}" @input="change($event)" style="width:100px"/>`;
@@ -110,7 +111,9 @@
         template,
         methods: {
           change(e) {
-            this.putData(this.ikey, inputHandler(e));
+            const value = inputHandler(e);
+            this.putData(this.ikey, value);
+            live.param(ctrl.parent, this.ikey, value);
             this.emitter.trigger('process');
           }
         }
@@ -188,28 +191,16 @@
   }
 
   // --- API functions ---
-  async function loadNodeTypes() {
+  // Whole catalog in one request: { version, types: { apiName: spec } }
+  async function loadCatalog() {
     try {
-      const response = await fetch('/types');
+      const response = await fetch('/catalog');
       if (!response.ok) {
-        throw new Error(`Failed to load types: ${response.statusText}`);
+        throw new Error(`Failed to load type catalog: ${response.statusText}`);
       }
       return await response.json();
     } catch (error) {
-      console.error('Error loading node types:', error);
-      throw error;
-    }
-  }
-
-  async function loadTypeSpec(typeName) {
-    try {
-      const response = await fetch(`/types/${typeName}`);
-      if (!response.ok) {
-        throw new Error(`Failed to load type spec for ${typeName}: ${response.statusText}`);
-      }
-      return await response.json();
-    } catch (error) {
-      console.error(`Error loading type spec for ${typeName}:`, error);
+      console.error('Error loading type catalog:', error);
       throw error;
     }
   }
@@ -228,15 +219,16 @@
   // Initialize dynamic components
   async function initializeDynamicComponents() {
     try {
-      // Load available node types
-      const rawTypeNames = await loadNodeTypes();
-      console.log('Loaded node types:', rawTypeNames);
+      // Load every type spec in one round trip
+      const catalog = await loadCatalog();
+      const rawTypeNames = Object.keys(catalog.types || {});
+      console.log(`Loaded node types (catalog ${catalog.version}):`, rawTypeNames);
 
-      // Load specs and group by internal spec name to collapse aliases
+      // Group by internal spec name to collapse aliases
       const groups = new Map(); // key: internalName, value: { spec, candidates: [apiName] }
       const loadedSpecs = new Map(); // apiName -> spec
       for (const typeName of rawTypeNames) {
-        const typeSpec = await loadTypeSpec(typeName);
+        const typeSpec = catalog.types[typeName];
         loadedSpecs.set(typeName, typeSpec);
         const key = typeSpec.name; // internal name from engine
         if (!groups.has(key)) groups.set(key, { spec: typeSpec, candidates: [] });
@@ -350,9 +342,92 @@
     await engine.process(editor.toJSON());
   };
   
+  // --- live session ---
+  // Once a plan has been loaded over the /live WebSocket the server keeps the
+  // graph resident: parameter edits, connection changes and added or removed
+  // nodes are sent as deltas and only outputs that changed come back. Without a socket (or in legacy
+  // mode) Run falls back to POST /run.
+  const live = {
+    ws: null,
+    open: false,
+    loaded: false,
+    seq: 0,
+    outputs: [],
+
+    connect() {
+      if (!window.WebSocket) return;
+      const ws = new WebSocket(`${location.protocol === 'https:' ? 'wss' : 'ws'}://${location.host}/live`);
+      ws.onopen = () => { this.open = true; };
+      ws.onclose = () => {
+        this.ws = null;
+        this.open = this.loaded = false;
+        setTimeout(() => this.connect(), 2000);
+      };
+      ws.onmessage = (ev) => this.receive(JSON.parse(ev.data));
+      this.ws = ws;
+    },
+
+    send(msg) {
+      if (!this.open) return false;
+      msg.seq = ++this.seq;
+      this.ws.send(JSON.stringify(msg));
+      return true;
+    },
+
+    load(planJson) {
+      this.loaded = this.send({ type: 'load', plan: JSON.parse(planJson) });
+      return this.loaded;
+    },
+
+    param(node, key, value) {
+      if (this.loaded && node) this.send({ type: 'param', node: node.id, key, value });
+    },
+
+    edge(type, connection) {
+      if (!this.loaded) return;
+      const from = connection.output.node;
+      const to = connection.input.node;
+      this.send({
+        type,
+        from: from.id,
+        fromOutput: Math.max(0, Array.from(from.outputs.keys()).indexOf(connection.output.key)),
+        to: to.id,
+        toInput: Math.max(0, Array.from(to.inputs.keys()).indexOf(connection.input.key)),
+      });
+    },
+
+    node(type, node) {
+      if (!this.loaded) return;
+      if (type === 'removeNode') return this.send({ type, node: node.id });
+      const params = {};
+      const component = comps[node.name];
+      for (const paramSpec of (component && component.typeSpec && component.typeSpec.params) || []) {
+        const value = node.data[paramSpec.name];
+        if (value !== undefined && value !== null) params[paramSpec.name] = value;
+      }
+      const output = node.name === 'OutputNumber' || node.name === 'OutputString';
+      this.send({ type, node: { id: node.id, type: node.name, params }, output });
+    },
+
+    receive(msg) {
+      if (msg.type === 'outputs') {
+        if (msg.full) this.outputs = [];
+        for (const o of msg.outputs) this.outputs[o.index] = o;
+        resultsEl.textContent = JSON.stringify({ outputs: this.outputs });
+      } else if (msg.type === 'error') {
+        resultsEl.textContent = JSON.stringify({ error: msg.error });
+      }
+    },
+  };
+  live.connect();
+
   // Initialize the dynamic system and start processing
   initializeDynamicComponents().then(() => {
     editor.on('process nodecreated noderemoved connectioncreated connectionremoved', process);
+    editor.on('connectioncreated', (c) => live.edge('connect', c));
+    editor.on('connectionremoved', (c) => live.edge('disconnect', c));
+    editor.on('nodecreated', (n) => live.node('addNode', n));
+    editor.on('noderemoved', (n) => live.node('removeNode', n));
     process();
   });
 
@@ -499,6 +574,7 @@
     const useLegacy = urlParams.get('legacy') === 'true';
     
     const plan = exportPlan(useLegacy);
+    if (!useLegacy && live.load(plan)) return;
     const contentType = useLegacy ? 'text/plain' : 'application/json';
     
     try {
@@ -0,0 +1,195 @@
+#!/usr/bin/env node
+// Replays a plan corpus (or generated plans) against libengine or a server.
+//
+//   node scripts/replay.js --corpus runs.jsonl [--target native|http://host:3000]
+//        [--concurrency 8] [--rate 200] [--requests 1000 | --duration 30]
+//   node scripts/replay.js --generate 500 --nodes 50 --seed 7 [--save-corpus gen.jsonl] ...
+//
+// --target native runs plans in-process through the engine addon (JSON plans
+// only); a URL posts them to <url>/run. Without --rate the replay is
+// closed-loop: `concurrency` clients each send the next plan as soon as the
+// previous one returns. With --rate R, requests arrive as a Poisson process at
+// R per second and at most `concurrency` are in flight; latency is measured
+// from the scheduled arrival, so client-side queueing under overload counts.
+// Plans are sent round-robin from the corpus until --requests (default: the
+// corpus size) or --duration is reached. Prints one JSON report on stdout.
+const http = require('http');
+const https = require('https');
+const { readCorpus, writeCorpus } = require('./corpus');
+const { generateGraph } = require('./graph_gen');
+
+function parseArgs(argv) {
+  const opts = { target: 'native', concurrency: 1, rate: 0, requests: 0, duration: 0, nodes: 20, seed: 1 };
+  const num = ['concurrency', 'rate', 'requests', 'duration', 'generate', 'nodes', 'seed'];
+  for (let i = 0; i < argv.length; i++) {
+    const key = argv[i].replace(/^--/, '').replace(/-([a-z])/g, (_, c) => c.toUpperCase());
+    const value = argv[++i];
+    if (value === undefined || !argv[i - 1].startsWith('--')) throw new Error(`bad argument ${argv[i - 1]}`);
+    opts[key] = num.includes(key) ? Number(value) : value;
+  }
+  return opts;
+}
+
+async function fetchCatalog(target) {
+  if (target === 'native') {
+    const native = require('./engine_native');
+    if (!native.addon) throw new Error(`engine addon unavailable: ${native.loadError && native.loadError.message}`);
+    return JSON.parse(native.addon.catalog());
+  }
+  const r = await post(new URL('/catalog', target), null);
+  if (r.status !== 200) throw new Error(`GET /catalog: HTTP ${r.status}`);
+  return JSON.parse(r.body);
+}
+
+const agents = {};
+function post(url, body) {
+  const lib = url.protocol === 'https:' ? https : http;
+  const agent = agents[url.protocol] || (agents[url.protocol] = new lib.Agent({ keepAlive: true }));
+  return new Promise((resolve, reject) => {
+    const req = lib.request(url, { method: body === null ? 'GET' : 'POST', agent, headers: { 'Content-Type': 'application/json' } }, (res) => {
+      const chunks = [];
+      res.on('data', (c) => chunks.push(c));
+      res.on('end', () => resolve({ status: res.statusCode, body: Buffer.concat(chunks).toString('utf8') }));
+    });
+    req.on('error', reject);
+    req.end(body === null ? undefined : body);
+  });
+}
+
+// Returns an async (plan) => errorKind|null for the target.
+function makeSender(target) {
+  if (target === 'native') {
+    const native = require('./engine_native');
+    if (!native.addon) throw new Error(`engine addon unavailable: ${native.loadError && native.loadError.message}`);
+    return async (plan) => {
+      if (typeof plan === 'string') return 'text_plan_unsupported';
+      try {
+        await native.runPlanJson(plan);
+        return null;
+      } catch (_) {
+        return 'engine_error';
+      }
+    };
+  }
+  const url = new URL('/run', target);
+  return async (plan) => {
+    try {
+      const r = await post(url, typeof plan === 'string' ? plan : JSON.stringify(plan));
+      return r.status === 200 ? null : `http_${r.status}`;
+    } catch (err) {
+      return err.code || 'network_error';
+    }
+  };
+}
+
+function percentile(sorted, q) {
+  if (!sorted.length) return null;
+  return sorted[Math.min(sorted.length - 1, Math.floor(q * sorted.length))];
+}
+
+async function replay(plans, send, { concurrency, rate, requests, duration }) {
+  const total = requests > 0 ? requests : duration > 0 ? Infinity : plans.length;
+  const deadline = duration > 0 ? Date.now() + duration * 1000 : Infinity;
+  const latencies = [];
+  const errors = {};
+  let issued = 0;
+
+  const record = (startNs, err) => {
+    latencies.push(Number(process.hrtime.bigint() - startNs) / 1e6);
+    if (err) errors[err] = (errors[err] || 0) + 1;
+  };
+  const more = () => issued < total && Date.now() < deadline;
+
+  const t0 = process.hrtime.bigint();
+  if (!rate) {
+    const client = async () => {
+      while (more()) {
+        const plan = plans[issued++ % plans.length];
+        const start = process.hrtime.bigint();
+        record(start, await send(plan));
+      }
+    };
+    await Promise.all(Array.from({ length: Math.max(1, concurrency) }, client));
+  } else {
+    // Open loop: arrivals follow their own schedule regardless of completions.
+    let inflight = 0;
+    const waiting = [];
+    const slot = () => (inflight < concurrency ? (inflight++, Promise.resolve()) : new Promise((r) => waiting.push(r)));
+    const release = () => { const next = waiting.shift(); if (next) next(); else inflight--; };
+    const pending = [];
+    let next = Number(t0);
+    while (more()) {
+      next += (-Math.log(1 - Math.random()) / rate) * 1e9;
+      const wait = (next - Number(process.hrtime.bigint())) / 1e6;
+      if (wait > 1) await new Promise((r) => setTimeout(r, wait));
+      const plan = plans[issued++ % plans.length];
+      const arrival = BigInt(Math.round(next));
+      pending.push(slot().then(async () => {
+        try { record(arrival, await send(plan)); } finally { release(); }
+      }));
+    }
+    await Promise.all(pending);
+  }
+  const elapsed = Number(process.hrtime.bigint() - t0) / 1e9;
+
+  latencies.sort((a, b) => a - b);
+  const failed = Object.values(errors).reduce((a, b) => a + b, 0);
+  const round = (v) => (v === null ? null : Math.round(v * 1000) / 1000);
+  return {
+    requests: latencies.length,
+    ok: latencies.length - failed,
+    errors: failed,
+    error_rate: latencies.length ? round(failed / latencies.length) : 0,
+    errors_by_kind: errors,
+    duration_s: round(elapsed),
+    throughput_rps: round(latencies.length / elapsed),
+    latency_ms: {
+      mean: round(latencies.reduce((a, b) => a + b, 0) / (latencies.length || 1)),
+      p50: round(percentile(latencies, 0.5)),
+      p90: round(percentile(latencies, 0.9)),
+      p99: round(percentile(latencies, 0.99)),
+      p999: round(percentile(latencies, 0.999)),
+      max: round(latencies[latencies.length - 1] ?? null),
+    },
+  };
+}
+
+async function main() {
+  const opts = parseArgs(process.argv.slice(2));
+  if (opts.target === 'native') require('./engine_native').reserveRunThreads(opts.concurrency);
+  let plans;
+  let skipped = 0;
+  if (opts.corpus) {
+    const c = readCorpus(opts.corpus);
+    plans = c.entries.map((e) => e.plan);
+    skipped = c.skipped;
+  } else if (opts.generate > 0) {
+    const catalog = await fetchCatalog(opts.target);
+    plans = Array.from({ length: opts.generate }, (_, i) => generateGraph(catalog, { nodes: opts.nodes, seed: opts.seed + i }));
+    if (opts.saveCorpus) writeCorpus(opts.saveCorpus, plans);
+  } else {
+    throw new Error('need --corpus <file> or --generate <count>');
+  }
+  if (!plans.length) throw new Error('no plans to replay');
+
+  const report = await replay(plans, makeSender(opts.target), opts);
+  console.log(JSON.stringify({
+    target: opts.target,
+    mode: opts.rate ? 'open' : 'closed',
+    concurrency: opts.concurrency,
+    rate: opts.rate || null,
+    plans: plans.length,
+    skipped_lines: skipped,
+    ...report,
+  }));
+  for (const a of Object.values(agents)) a.destroy();
+}
+
+if (require.main === module) {
+  main().catch((err) => {
+    console.error(`replay: ${err.message || err}`);
+    process.exit(1);
+  });
+}
+
+module.exports = { replay, makeSender };
@@ -1,7 +1,16 @@
 const express = require('express');
 const { spawnSync } = require('child_process');
+const os = require('os');
 const path = require('path');
 const fs = require('fs');
+const { WorkerPool } = require('./worker_pool');
+const native = require('./engine_native');
+const { GraphCache } = require('./graph_cache');
+const { Admission, QueueFullError, planTypes, estimateCost } = require('./admission');
+const { SingleFlight, planKey } = require('./single_flight');
+const { LiveSession } = require('./live_session');
+const { CorpusRecorder } = require('./corpus');
+const { WebSocketServer } = require('ws');
 
 const app = express();
 const port = 3000;
@@ -33,24 +42,13 @@ function resolveLuajit() {
   return null;
 }
 
-app.use(express.static(path.join(__dirname, 'public')));
-
-app.get('/set', (req, res) => {
-  const value = req.query.value || '0';
-  console.log(`[noop:/set] value=${value}`);
-  res.send('OK');
-});
-
-// Node types API endpoints
-app.get('/types', (req, res) => {
-  const luaScript = path.join(__dirname, 'lua', 'list_types.lua');
+// Long-lived LuaJIT workers (scripts/lua/run_graph.lua --worker), created on
+// first use. Size with $TAZOR_WORKERS (default: one per CPU).
+let pool = null;
+function getPool() {
+  if (pool) return pool;
   const luajitCmd = resolveLuajit();
-  
-  if (!luajitCmd) {
-    return res.status(500).json({
-      error: 'LuaJIT not found. Build the vendored ./luajit (see scripts/build_luajit.sh) or install system luajit, or set $LUAJIT.',
-    });
-  }
+  if (!luajitCmd) return null;
 
   // Include local libs so luajit runs without system install
   const extraLibDirs = [
@@ -64,122 +62,381 @@ app.get('/types', (req, res) => {
       .join(':'),
   };
 
-  const result = spawnSync(luajitCmd, [luaScript], {
-    encoding: 'utf8',
-    cwd: repoRoot,
+  pool = new WorkerPool({
+    command: luajitCmd,
+    args: [path.join(__dirname, 'lua', 'run_graph.lua'), '--worker'],
+    cwd: repoRoot, // critical: lets run_graph.lua load "./libengine.so"
     env,
+    size: parseInt(process.env.TAZOR_WORKERS, 10) || os.cpus().length,
   });
+  return pool;
+}
 
-  if (result.error) {
-    console.error(result.error);
-    return res.status(500).json({ error: String(result.error) });
+const luajitMissing = 'LuaJIT not found. Build the vendored ./luajit (see scripts/build_luajit.sh) or install system luajit, or set $LUAJIT.';
+
+// Sends one request to the worker pool and relays the JSON result.
+// failStatus is used when the engine reports an error.
+async function relay(res, op, body, failStatus) {
+  const p = getPool();
+  if (!p) return res.status(500).json({ error: luajitMissing });
+  let result;
+  try {
+    result = await p.request(op, body);
+  } catch (err) {
+    console.error(err);
+    return res.status(500).json({ error: String(err.message || err) });
   }
+  if (!result.ok) return res.status(failStatus).type('application/json').send(result.body);
+  return result.body;
+}
 
-  const stdout = (result.stdout || '').trim();
-  const stderr = (result.stderr || '').trim();
+if (native.addon) {
+  console.log('Using in-process engine addon');
+} else {
+  console.log(`Engine addon unavailable (${native.loadError && native.loadError.message}); using LuaJIT workers`);
+}
 
-  if (result.status !== 0) {
-    if (stderr) return res.status(400).type('application/json').send(stderr);
-    return res.status(400).json({ error: 'Failed to list types' });
-  }
+// Resident compiled graphs for repeated topologies (addon only).
+// Budget with $TAZOR_GRAPH_CACHE_MB (default 64, 0 disables).
+const cacheMb = process.env.TAZOR_GRAPH_CACHE_MB !== undefined ? Number(process.env.TAZOR_GRAPH_CACHE_MB) : 64;
+const graphCache = native.addon && cacheMb > 0 ? new GraphCache({ budgetBytes: cacheMb * 1024 * 1024 }) : null;
 
-  res.type('application/json').send(stdout || '[]');
+// Admission control for /run: $TAZOR_RUN_CONCURRENCY runs at once (default:
+// one per CPU), $TAZOR_RUN_QUEUE waiting (default 256), and plans whose
+// estimated cost exceeds $TAZOR_RUN_COST_BUDGET (default: unlimited) are refused.
+// Each admitted run occupies a libuv threadpool thread, so the pool is sized
+// to match here, before the server does any asynchronous I/O.
+const runConcurrency = parseInt(process.env.TAZOR_RUN_CONCURRENCY, 10) || os.cpus().length;
+native.reserveRunThreads(runConcurrency);
+const admission = new Admission({
+  concurrency: runConcurrency,
+  queueLimit: process.env.TAZOR_RUN_QUEUE !== undefined ? parseInt(process.env.TAZOR_RUN_QUEUE, 10) : 256,
 });
+const costBudget = Number(process.env.TAZOR_RUN_COST_BUDGET) || Infinity;
 
-app.get('/types/:typeName', (req, res) => {
-  const typeName = req.params.typeName;
-  const luaScript = path.join(__dirname, 'lua', 'get_type_spec.lua');
-  const luajitCmd = resolveLuajit();
-  
-  if (!luajitCmd) {
-    return res.status(500).json({
-      error: 'LuaJIT not found. Build the vendored ./luajit (see scripts/build_luajit.sh) or install system luajit, or set $LUAJIT.',
-    });
+// Per-type cost and determinism from the catalog, refreshed when its version changes
+let typeInfo = { version: null, costs: new Map(), deterministic: new Set() };
+async function loadTypeInfo() {
+  let text;
+  if (native.addon) {
+    if (native.addon.catalogVersion() === typeInfo.version) return typeInfo;
+    text = native.addon.catalog();
+  } else {
+    if (typeInfo.version !== null) return typeInfo; // workers never load plugins at runtime
+    const p = getPool();
+    const r = p && (await p.request('C'));
+    if (!r || !r.ok) return typeInfo;
+    text = r.body;
+  }
+  const catalog = JSON.parse(text);
+  const costs = new Map();
+  const deterministic = new Set();
+  for (const [name, spec] of Object.entries(catalog.types || {})) {
+    costs.set(name, Number(spec.cost) || 1);
+    if (spec.deterministic !== false) deterministic.add(name);
   }
+  typeInfo = { version: catalog.version, costs, deterministic };
+  return typeInfo;
+}
 
-  // Include local libs so luajit runs without system install
-  const extraLibDirs = [
-    path.join(repoRoot, 'scripts', 'bin'),
-    path.join(repoRoot, 'luajit', 'src'),
-  ];
-  const env = {
-    ...process.env,
-    LD_LIBRARY_PATH: [extraLibDirs.join(':'), process.env.LD_LIBRARY_PATH || '']
-      .filter(Boolean)
-      .join(':'),
-  };
+// Identical concurrent /run requests share one execution. With
+// $TAZOR_RESULT_CACHE_MS > 0, successful results of plans made only of
+// deterministic node types are also reused for that long (default 0: off).
+const singleFlight = new SingleFlight({ ttlMs: Number(process.env.TAZOR_RESULT_CACHE_MS) || 0 });
 
-  const result = spawnSync(luajitCmd, [luaScript, typeName], {
-    encoding: 'utf8',
-    cwd: repoRoot,
-    env,
-  });
+// With $TAZOR_RECORD_CORPUS set, every /run plan is appended to that file for
+// offline replay (scripts/replay.js).
+const recorder = process.env.TAZOR_RECORD_CORPUS ? new CorpusRecorder(process.env.TAZOR_RECORD_CORPUS) : null;
 
-  if (result.error) {
-    console.error(result.error);
-    return res.status(500).json({ error: String(result.error) });
+// Executes one /run plan. Resolves to { status, body, headers } rather than
+// writing the response, so coalesced requests can share it.
+async function executeRun(parsed, plan) {
+  if (parsed) {
+    try {
+      if (!graphCache) return { status: 200, body: await native.runPlanJson(parsed) };
+      const { json, cached } = await graphCache.run(parsed, { json: true });
+      return { status: 200, body: json, headers: { 'X-Graph-Cache': cached ? 'hit' : 'miss' } };
+    } catch (err) {
+      return { status: 400, body: JSON.stringify({ error: String(err.message || err) }) };
+    }
   }
 
-  const stdout = (result.stdout || '').trim();
-  const stderr = (result.stderr || '').trim();
+  const p = getPool();
+  if (!p) return { status: 500, body: JSON.stringify({ error: luajitMissing }) };
+  try {
+    const r = await p.request('R', plan);
+    return r.ok ? { status: 200, body: r.body || '{"outputs":[]}' } : { status: 400, body: r.body };
+  } catch (err) {
+    console.error(err);
+    return { status: 500, body: JSON.stringify({ error: String(err.message || err) }) };
+  }
+}
+
+app.use(express.static(path.join(__dirname, 'public')));
+
+app.get('/set', (req, res) => {
+  const value = req.query.value || '0';
+  console.log(`[noop:/set] value=${value}`);
+  res.send('OK');
+});
+
+// Node types API endpoints
+app.get('/types', async (req, res) => {
+  if (native.addon) return res.type('application/json').send(native.addon.listTypes());
+  const out = await relay(res, 'L', '', 400);
+  if (typeof out === 'string') res.type('application/json').send(out || '[]');
+});
+
+// Full type catalog in one document, cacheable by its version hash
+app.get('/catalog', async (req, res) => {
+  const out = native.addon ? native.addon.catalog() : await relay(res, 'C', '', 400);
+  if (typeof out !== 'string') return;
 
-  if (result.status !== 0) {
-    if (stderr) return res.status(400).type('application/json').send(stderr);
-    return res.status(404).json({ error: `Type '${typeName}' not found` });
+  // The version hash leads the document: {"version":"<hash>",...}
+  const m = /^\{"version":"([0-9a-f]+)"/.exec(out);
+  if (m) {
+    const etag = `"${m[1]}"`;
+    res.set('ETag', etag);
+    res.set('Cache-Control', 'no-cache');
+    if (req.get('If-None-Match') === etag) return res.status(304).end();
   }
 
-  res.type('application/json').send(stdout || '{}');
+  res.type('application/json').send(out || '{"types":{}}');
 });
 
-app.post('/run', express.raw({ type: '*/*', limit: '1mb' }), (req, res) => {
-  const contentType = req.get('Content-Type') || '';
+app.get('/types/:typeName', async (req, res) => {
+  const typeName = req.params.typeName;
+  if (native.addon) {
+    const spec = native.addon.typeSpec(typeName);
+    if (spec === null) return res.status(404).json({ error: `engine_get_type_spec: unknown type '${typeName}'` });
+    return res.type('application/json').send(spec);
+  }
+  const out = await relay(res, 'T', typeName, 404);
+  if (typeof out === 'string') res.type('application/json').send(out || '{}');
+});
+
+app.post('/run', express.raw({ type: '*/*', limit: '1mb' }), async (req, res) => {
   const rawBody = req.body || Buffer.alloc(0);
   const plan = rawBody.toString('utf8');
-  
-  const luaScript = path.join(__dirname, 'lua', 'run_graph.lua');
 
-  const luajitCmd = resolveLuajit();
-  if (!luajitCmd) {
-    return res.status(500).json({
-      error: 'LuaJIT not found. Build the vendored ./luajit (see scripts/build_luajit.sh) or install system luajit, or set $LUAJIT.',
-    });
+  // JSON v1 plans run in-process; text plans (and everything without the addon) go to the workers
+  let parsed = null;
+  if (native.addon) {
+    try { parsed = JSON.parse(plan); } catch (_) { parsed = null; }
   }
+  if (parsed && typeof parsed !== 'object') parsed = null;
+  if (recorder) recorder.record(parsed || plan);
+  const shapeError = parsed && native.planShapeError(parsed);
+  if (shapeError) return res.status(400).json({ error: shapeError });
 
-  // Include local libs so luajit runs without system install
-  const extraLibDirs = [
-    path.join(repoRoot, 'scripts', 'bin'),
-    path.join(repoRoot, 'luajit', 'src'),
-  ];
-  const env = {
-    ...process.env,
-    LD_LIBRARY_PATH: [extraLibDirs.join(':'), process.env.LD_LIBRARY_PATH || '']
-      .filter(Boolean)
-      .join(':'),
-  };
+  let deterministic = false;
+  let key;
+  try {
+    if (costBudget !== Infinity || singleFlight.ttlMs > 0) {
+      const info = await loadTypeInfo();
+      const cost = estimateCost(parsed || plan, info.costs);
+      if (cost > costBudget) {
+        return res.status(413).json({ error: `plan cost ${cost} exceeds budget ${costBudget}` });
+      }
+      deterministic = planTypes(parsed || plan).every((t) => info.deterministic.has(t));
+    }
+    key = planKey(parsed || plan);
+  } catch (err) {
+    return res.status(500).json({ error: String(err.message || err) });
+  }
 
-  const result = spawnSync(luajitCmd, [luaScript], {
-    input: plan,
-    encoding: 'utf8',
-    cwd: repoRoot, // critical: lets run_graph.lua load "./libengine.so"
-    env,
-  });
+  try {
+    const { value, source } = await singleFlight.run(
+      key,
+      deterministic,
+      () => admission.run(() => executeRun(parsed, plan)),
+      (r) => r.status === 200,
+    );
+    if (value.headers) res.set(value.headers);
+    res.set('X-Run-Dedupe', source);
+    res.status(value.status).type('application/json').send(value.body);
+  } catch (err) {
+    if (!(err instanceof QueueFullError)) return res.status(500).json({ error: String(err.message || err) });
+    res.set('Retry-After', String(err.retryAfterSec));
+    res.status(503).json({ error: 'server busy, retry later' });
+  }
+});
 
-  if (result.error) {
-    console.error(result.error);
-    return res.status(500).json({ error: String(result.error) });
+// Prometheus metrics: the engine's run counters and latency histograms
+// (tazor_engine_*, in-process addon only; LuaJIT workers keep their own) plus
+// the server's admission and dedupe state.
+app.get('/metrics', (req, res) => {
+  const a = admission.stats();
+  const sf = singleFlight.stats;
+  let out = native.addon ? native.addon.metrics() : '';
+  out += '# HELP tazor_server_runs_in_flight Runs currently executing.\n# TYPE tazor_server_runs_in_flight gauge\n' +
+    `tazor_server_runs_in_flight ${a.running}\n`;
+  out += '# HELP tazor_server_runs_queued Runs waiting for an admission slot.\n# TYPE tazor_server_runs_queued gauge\n' +
+    `tazor_server_runs_queued ${a.queued}\n`;
+  out += '# HELP tazor_server_run_requests_total /run requests by how they were served.\n# TYPE tazor_server_run_requests_total counter\n' +
+    `tazor_server_run_requests_total{source="run"} ${sf.runs}\n` +
+    `tazor_server_run_requests_total{source="joined"} ${sf.joined}\n` +
+    `tazor_server_run_requests_total{source="cache"} ${sf.cached}\n`;
+  res.type('text/plain; version=0.0.4').send(out);
+});
+
+// Same body as /run, executed once on a fresh graph with per-node profiling:
+// {"outputs":[...],"profile":{"run_us","workers","nodes":[...]}}. Never
+// coalesced or served from a cache, so the timings are from this run.
+app.post('/profile', express.raw({ type: '*/*', limit: '1mb' }), async (req, res) => {
+  const plan = (req.body || Buffer.alloc(0)).toString('utf8');
+  let parsed = null;
+  if (native.addon) {
+    try { parsed = JSON.parse(plan); } catch (_) { parsed = null; }
   }
+  if (parsed && typeof parsed !== 'object') parsed = null;
+
+  try {
+    await admission.run(async () => {
+      if (!parsed) {
+        const out = await relay(res, 'P', plan, 400);
+        if (typeof out === 'string') res.type('application/json').send(out);
+        return;
+      }
+      try {
+        res.type('application/json').send(await native.runPlanProfiled(parsed));
+      } catch (err) {
+        res.status(400).json({ error: String(err.message || err) });
+      }
+    });
+  } catch (err) {
+    if (!(err instanceof QueueFullError)) {
+      if (!res.headersSent) res.status(500).json({ error: String(err.message || err) });
+      return;
+    }
+    res.set('Retry-After', String(err.retryAfterSec));
+    res.status(503).json({ error: 'server busy, retry later' });
+  }
+});
 
-  const stdout = (result.stdout || '').trim();
-  const stderr = (result.stderr || '').trim();
+// Many independent JSON v1 plans in one request: {"plans":[...]} or a bare
+// array. With the addon they run as one combined engine task graph; results
+// come back in order as {outputs} or {error}, one per plan. The batch takes a
+// single admission slot and the cost budget applies to its total.
+app.post('/run/batch', express.json({ limit: '16mb' }), async (req, res) => {
+  const plans = Array.isArray(req.body) ? req.body : req.body && req.body.plans;
+  if (!Array.isArray(plans)) return res.status(400).json({ error: 'expected {"plans":[...]} or an array of plans' });
 
-  if (result.status !== 0) {
-    if (stderr) return res.status(400).type('application/json').send(stderr);
-    return res.status(400).json({ error: 'Run failed' });
+  if (costBudget !== Infinity) {
+    for (let i = 0; i < plans.length; i++) {
+      const shapeError = native.planShapeError(plans[i]);
+      if (shapeError) return res.status(400).json({ error: `plans[${i}]: ${shapeError}` });
+    }
+    try {
+      const { costs } = await loadTypeInfo();
+      const cost = plans.reduce((sum, p) => sum + estimateCost(p, costs), 0);
+      if (cost > costBudget) {
+        return res.status(413).json({ error: `batch cost ${cost} exceeds budget ${costBudget}` });
+      }
+    } catch (err) {
+      return res.status(500).json({ error: String(err.message || err) });
+    }
   }
 
-  res.type('application/json').send(stdout || '{"outputs":[]}');
+  try {
+    const results = await admission.run(async () => {
+      if (native.addon) return native.runBatch(plans);
+      return Promise.all(plans.map((p) => runPlanOnPool(p).catch((err) => ({ error: String(err.message || err) }))));
+    });
+    res.json({ results });
+  } catch (err) {
+    if (!(err instanceof QueueFullError)) return res.status(500).json({ error: String(err.message || err) });
+    res.set('Retry-After', String(err.retryAfterSec));
+    res.status(503).json({ error: 'server busy, retry later' });
+  }
 });
 
-app.listen(port, () => {
+// Runs a JSON v1 plan on the worker pool; used by live sessions without the addon.
+async function runPlanOnPool(plan) {
+  const p = getPool();
+  if (!p) throw new Error('LuaJIT not found');
+  const r = await p.request('R', JSON.stringify(plan));
+  const body = JSON.parse(r.body || '{}');
+  if (!r.ok) throw new Error(body.error || 'run failed');
+  return body;
+}
+
+// Live sessions: the editor loads its plan once over /live, then streams
+// parameter, edge and node deltas (see live_session.js); only outputs that
+// changed are pushed back, or all of them when the output pins changed.
+//   server -> client: {type:'outputs', seq, full, outputs:[{index,type,value}]}
+//                     {type:'error', seq, error} / {type:'busy', retryAfter}
+function serveLive(ws) {
+  const session = new LiveSession({ runPlan: runPlanOnPool });
+  let running = false;
+  let closed = false;
+  let seq = 0; // last client message applied
+  let full = false; // next push carries every output (after a load or a pin change)
+  const send = (msg) => { if (ws.readyState === ws.OPEN) ws.send(JSON.stringify(msg)); };
+
+  async function drain() {
+    if (running || closed) return; // the loop below picks up whatever arrives meanwhile
+    running = true;
+    try {
+      while (session.dirty && !closed) {
+        const at = seq;
+        const isFull = full;
+        full = false;
+        try {
+          const outputs = await admission.run(() => session.run());
+          if (isFull || outputs.length) send({ type: 'outputs', seq: at, full: isFull, outputs });
+        } catch (err) {
+          if (err instanceof QueueFullError) {
+            full = full || isFull;
+            send({ type: 'busy', retryAfter: err.retryAfterSec });
+            setTimeout(drain, err.retryAfterSec * 1000);
+            return;
+          }
+          send({ type: 'error', seq: at, error: String(err.message || err) });
+        }
+      }
+    } finally {
+      running = false;
+      if (closed) session.close();
+    }
+  }
+
+  ws.on('message', (data) => {
+    let msg;
+    try {
+      msg = JSON.parse(String(data));
+      if (!msg || typeof msg !== 'object') throw new Error('message must be an object');
+      if (msg.type === 'load') {
+        session.load(msg.plan);
+        full = true;
+      } else if (msg.type === 'param') {
+        session.setParam(msg.node, msg.key, msg.value);
+      } else if (msg.type === 'connect') {
+        session.connect(msg);
+      } else if (msg.type === 'disconnect') {
+        session.disconnect(msg);
+      } else if (msg.type === 'addNode') {
+        if (session.addNode(msg.node, { output: !!msg.output })) full = true;
+      } else if (msg.type === 'removeNode') {
+        if (session.removeNode(msg.node)) full = true;
+      } else if (msg.type === 'retypeNode') {
+        session.retypeNode(msg.node, msg.nodeType);
+      } else {
+        throw new Error(`unknown message type '${msg.type}'`);
+      }
+    } catch (err) {
+      return send({ type: 'error', seq: msg && msg.seq, error: String(err.message || err) });
+    }
+    if (typeof msg.seq === 'number') seq = msg.seq;
+    drain();
+  });
+  ws.on('close', () => {
+    closed = true;
+    if (!running) session.close(); // otherwise drain() disposes once the run finishes
+  });
+}
+
+const server = app.listen(port, () => {
   console.log(`Server listening on http://localhost:${port}`);
 });
+new WebSocketServer({ server, path: '/live' }).on('connection', serveLive);
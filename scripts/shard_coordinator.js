@@ -0,0 +1,362 @@
+#!/usr/bin/env node
+// Sharded execution of one large graph across local engine processes.
+//
+//   const g = await ShardedGraph.create(plan, { shards: 4 });
+//   const outputs = await g.run();     // [{ index, type, value }] like Graph.run()
+//   g.setParam(node, key, value); await g.run();
+//   await g.close();
+//
+// The plan is split by partitionPlan (partition.js) into K monotone shards,
+// and each shard is loaded into its own shard_worker.js process. The
+// coordinator listens on a Unix domain socket and the workers connect to it.
+// A cut edge u.o -> v.i becomes an output pin on u's shard and a placeholder
+// source node (the catalog's source type for that socket type, e.g. Number or
+// String) on v's shard, wired to v.i. Each placeholder is shared by all of
+// v's shard's consumers of u.o.
+//
+// A run starts every shard whose upstream shards have finished, then relays
+// each boundary value from producer to consumer. Shards whose inputs and
+// parameters did not change since their last successful run are skipped.
+// Inside a shard the resident graph recomputes only what changed. Boundary
+// values travel through the coordinator; workers never talk to each other.
+//
+// CLI, for trying a partitioning on a plan file or a generated plan:
+//   node scripts/shard_coordinator.js --plan big.json --shards 4 [--runs 3] [--check]
+//   node scripts/shard_coordinator.js --generate 100000 --seed 7 --shards 8 --check
+// --check also runs the plan in-process and compares the outputs.
+const net = require('net');
+const os = require('os');
+const path = require('path');
+const { spawn } = require('child_process');
+const native = require('./engine_native');
+const { partitionPlan } = require('./partition');
+const { writeFrame, readFrames, decodeValue } = require('./shard_protocol');
+
+let socketSeq = 0;
+
+// A catalog type with no inputs, one output of `socket` type and a parameter
+// of the same type: the placeholder that feeds a boundary value into a shard.
+function sourceTypeFor(catalog, socket) {
+  for (const spec of Object.values(catalog.types || {})) {
+    if ((spec.inputs || []).length || (spec.outputs || []).length !== 1 || spec.outputs[0] !== socket) continue;
+    const param = (spec.params || []).find((p) => p.type === socket);
+    if (param) return { type: spec.name, key: param.name };
+  }
+  throw new Error(`shard: no source node type for '${socket}' boundary values`);
+}
+
+// Splits `plan` into per-shard plans. Returns { part, shards, finalOutputs } where
+// shards[s] = { plan, imports: [{ node, key, from: { shard, index } }], exports: [{ node, output }] }
+// and finalOutputs[i] = { shard, index } locates the plan's i-th output pin.
+function buildShards(plan, catalog, k, imbalance) {
+  const costOf = (n) => ((catalog.types || {})[n.type] || {}).cost ?? 1;
+  const part = partitionPlan(plan, k, { cost: costOf, imbalance });
+  const nodes = new Map((plan.nodes || []).map((n) => [n.id, n]));
+  let nextId = -1; // placeholder ids, below every plan id
+  for (const id of nodes.keys()) if (id <= nextId) nextId = id - 1;
+
+  const shards = part.shards.map(() => ({
+    plan: { version: 1, nodes: [], edges: { data: [], control: [] }, outputs: [] },
+    imports: [],
+    exports: [],
+    importIndex: new Map(), // "node:output" -> placeholder node id
+    exportIndex: new Map(), // "node:output" -> output pin index
+  }));
+  for (const n of plan.nodes || []) shards[part.shardOf.get(n.id)].plan.nodes.push(n);
+
+  const exportPin = (s, node, output) => {
+    const sh = shards[s];
+    const key = `${node}:${output}`;
+    if (!sh.exportIndex.has(key)) {
+      sh.exportIndex.set(key, sh.exports.length);
+      sh.exports.push({ node, output });
+      sh.plan.outputs.push({ node, output });
+    }
+    return sh.exportIndex.get(key);
+  };
+
+  // Edges keep their plan order within each shard (a later edge into the same input wins)
+  for (const e of (plan.edges && plan.edges.data) || []) {
+    const from = part.shardOf.get(e.from);
+    const to = part.shardOf.get(e.to);
+    const fromOutput = e.fromOutput || 0;
+    const toInput = e.toInput || 0;
+    if (from === to) {
+      shards[to].plan.edges.data.push({ from: e.from, fromOutput, to: e.to, toInput });
+      continue;
+    }
+    const sh = shards[to];
+    const key = `${e.from}:${fromOutput}`;
+    if (!sh.importIndex.has(key)) {
+      const spec = (catalog.types || {})[nodes.get(e.from).type];
+      if (!spec || fromOutput >= (spec.outputs || []).length) throw new Error(`shard: node ${e.from} has no output ${fromOutput}`);
+      const source = sourceTypeFor(catalog, spec.outputs[fromOutput]);
+      const id = nextId--;
+      sh.plan.nodes.push({ id, type: source.type });
+      sh.imports.push({ node: id, key: source.key, from: { shard: from, index: exportPin(from, e.from, fromOutput) } });
+      sh.importIndex.set(key, id);
+    }
+    sh.plan.edges.data.push({ from: sh.importIndex.get(key), fromOutput: 0, to: e.to, toInput });
+  }
+
+  const finalOutputs = (plan.outputs || []).map((o) => {
+    const s = part.shardOf.get(o.node);
+    if (s === undefined) throw new Error(`shard: output names unknown node ${o.node}`);
+    return { shard: s, index: exportPin(s, o.node, o.output || 0) };
+  });
+  return { part, shards, finalOutputs };
+}
+
+function sameValue(a, b) {
+  return !!a && !!b && a.type === b.type && a.value === b.value && a.special === b.special;
+}
+
+class ShardedGraph {
+  // Options: shards (default 2), imbalance (partition.js), catalog (parsed
+  // node-type catalog; default: the engine addon's), connectTimeoutMs.
+  static async create(plan, { shards = 2, imbalance = 0.1, catalog = null, connectTimeoutMs = 10000 } = {}) {
+    if (!plan || typeof plan !== 'object' || Array.isArray(plan)) throw new Error('Invalid JSON: root must be object');
+    if (plan.version !== 1) throw new Error(`Unsupported plan version: ${plan.version}`);
+    if (!catalog) {
+      if (!native.addon) throw new Error(`engine addon unavailable: ${native.loadError && native.loadError.message}`);
+      catalog = JSON.parse(native.addon.catalog());
+    }
+    const g = new ShardedGraph(plan, buildShards(plan, catalog, shards, imbalance));
+    try {
+      await g._start(connectTimeoutMs);
+      await Promise.all(g.shards.map((sh, s) => g._call(s, { type: 'load', plan: sh.plan, imports: sh.imports.map(({ node, key }) => ({ node, key })) })));
+    } catch (err) {
+      await g.close();
+      throw err;
+    }
+    return g;
+  }
+
+  constructor(plan, { part, shards, finalOutputs }) {
+    this.plan = plan;
+    this.part = part;
+    this.shards = shards.map((sh) => ({
+      ...sh,
+      deps: [...new Set(sh.imports.map((i) => i.from.shard))],
+      worker: null,
+      socket: null,
+      pending: new Map(),
+      nextId: 1,
+      params: new Map(), // "node\0key" -> { node, key, value }, sent with the next run
+      sent: new Array(sh.imports.length).fill(null), // boundary values the worker has
+      outputs: null, // encoded output pin values of the last successful run
+    }));
+    this.finalOutputs = finalOutputs;
+    this.failed = null;
+    this.running = false;
+  }
+
+  get stats() {
+    return {
+      shards: this.shards.length,
+      nodes: this.part.shards.map((ids) => ids.length),
+      loads: this.part.loads,
+      cut_edges: this.part.cutEdges,
+      boundary_values: this.shards.reduce((n, sh) => n + sh.imports.length, 0),
+    };
+  }
+
+  setParam(node, key, value) {
+    const s = this.part.shardOf.get(node);
+    if (s === undefined) throw new Error(`unknown node ${node}`);
+    this.shards[s].params.set(`${node}\0${key}`, { node, key, value });
+  }
+
+  async run() {
+    if (this.failed) throw this.failed;
+    if (this.running) throw new Error('graph is running');
+    this.running = true;
+    try {
+      const done = [];
+      this.shards.forEach((sh, s) => {
+        done[s] = Promise.all(sh.deps.map((d) => done[d])).then(() => this._runShard(s));
+      });
+      const results = await Promise.allSettled(done);
+      const failed = results.findIndex((r) => r.status === 'rejected');
+      if (failed >= 0) throw results[failed].reason;
+    } finally {
+      this.running = false;
+    }
+    return this.finalOutputs.map(({ shard, index }, i) => {
+      const v = this.shards[shard].outputs[index];
+      return { index: i, type: v.type, value: decodeValue(v) };
+    });
+  }
+
+  async close() {
+    this.failed = this.failed || new Error('sharded graph closed');
+    for (const sh of this.shards) {
+      if (sh.socket && !sh.socket.destroyed) {
+        writeFrame(sh.socket, { type: 'close' });
+        sh.socket.end();
+      }
+    }
+    await Promise.all(this.shards.map((sh) => sh.worker && sh.worker.exitCode === null && sh.worker.signalCode === null
+      ? new Promise((resolve) => {
+        const t = setTimeout(() => sh.worker.kill(), 2000);
+        sh.worker.once('exit', () => { clearTimeout(t); resolve(); });
+      })
+      : null));
+    if (this.server) this.server.close();
+  }
+
+  async _runShard(s) {
+    const sh = this.shards[s];
+    let changed = !sh.outputs || sh.params.size > 0;
+    const inputs = sh.imports.map((imp, i) => {
+      const v = this.shards[imp.from.shard].outputs[imp.from.index];
+      if (sameValue(v, sh.sent[i])) return null;
+      changed = true;
+      return v;
+    });
+    if (!changed) return;
+    const params = [...sh.params.values()];
+    sh.params.clear();
+    sh.outputs = null; // until this run succeeds
+    try {
+      sh.outputs = (await this._call(s, { type: 'run', inputs, params })).outputs;
+    } catch (err) {
+      // Resend everything with the next run (setting a value twice is harmless);
+      // parameters set since this run started are newer and win
+      for (const p of params) {
+        const key = `${p.node}\0${p.key}`;
+        if (!sh.params.has(key)) sh.params.set(key, p);
+      }
+      throw new Error(`shard ${s}: ${err.message}`);
+    }
+    // Only now does the worker certainly hold these boundary values
+    inputs.forEach((v, i) => { if (v) sh.sent[i] = v; });
+  }
+
+  _call(s, msg) {
+    const sh = this.shards[s];
+    if (this.failed) return Promise.reject(this.failed);
+    return new Promise((resolve, reject) => {
+      const id = sh.nextId++;
+      sh.pending.set(id, { resolve, reject });
+      writeFrame(sh.socket, { id, ...msg });
+    });
+  }
+
+  _onReply(s, msg) {
+    const job = this.shards[s].pending.get(msg.id);
+    if (!job) return;
+    this.shards[s].pending.delete(msg.id);
+    if (msg.ok) job.resolve(msg);
+    else job.reject(new Error(msg.error));
+  }
+
+  _onExit(s, err) {
+    this.failed = this.failed || err;
+    const sh = this.shards[s];
+    for (const job of sh.pending.values()) job.reject(err);
+    sh.pending.clear();
+  }
+
+  // Listens on a fresh Unix socket, spawns one worker per shard and waits
+  // until each has connected and said hello.
+  _start(timeoutMs) {
+    const socketPath = path.join(os.tmpdir(), `tazor-shards-${process.pid}-${socketSeq++}.sock`);
+    const worker = path.join(__dirname, 'shard_worker.js');
+    return new Promise((resolve, reject) => {
+      let connected = 0;
+      const timer = setTimeout(() => reject(new Error(`shard workers did not connect within ${timeoutMs} ms`)), timeoutMs);
+      const fail = (err) => { clearTimeout(timer); reject(err); };
+
+      this.server = net.createServer((socket) => {
+        let shard = -1;
+        readFrames(socket, (msg) => {
+          if (shard >= 0) return this._onReply(shard, msg);
+          if (msg.type !== 'hello' || !this.shards[msg.shard] || this.shards[msg.shard].socket) return socket.destroy();
+          shard = msg.shard;
+          this.shards[shard].socket = socket;
+          if (++connected === this.shards.length) {
+            clearTimeout(timer);
+            this.server.close(); // every worker is in; stop accepting (also unlinks the socket)
+            resolve();
+          }
+        });
+        socket.on('error', () => {}); // surfaced through 'close'
+        socket.on('close', () => { if (shard >= 0) this._onExit(shard, new Error(`shard ${shard} disconnected`)); });
+      });
+      this.server.on('error', fail);
+      this.server.listen(socketPath, () => {
+        this.shards.forEach((sh, s) => {
+          sh.worker = spawn(process.execPath, [worker, socketPath, String(s)], { stdio: ['ignore', 'inherit', 'pipe'] });
+          sh.worker.stderr.on('data', (chunk) => {
+            for (const line of String(chunk).split('\n')) if (line) process.stderr.write(`[shard ${s}] ${line}\n`);
+          });
+          sh.worker.on('error', (err) => { this._onExit(s, err); fail(err); });
+          sh.worker.on('exit', (code, signal) => {
+            const err = new Error(`shard ${s} exited (${signal || code})`);
+            this._onExit(s, err);
+            fail(err);
+          });
+        });
+      });
+    });
+  }
+}
+
+function parseArgs(argv) {
+  const opts = { shards: 2, runs: 1, seed: 1, imbalance: 0.1, check: false };
+  for (let i = 0; i < argv.length; i++) {
+    const key = argv[i].replace(/^--/, '');
+    if (key === 'check') { opts.check = true; continue; }
+    const value = argv[++i];
+    if (value === undefined || !argv[i - 1].startsWith('--')) throw new Error(`bad argument ${argv[i - 1]}`);
+    opts[key] = key === 'plan' ? value : Number(value);
+  }
+  return opts;
+}
+
+async function main() {
+  const opts = parseArgs(process.argv.slice(2));
+  let plan;
+  if (opts.plan) {
+    plan = JSON.parse(require('fs').readFileSync(opts.plan, 'utf8'));
+  } else if (opts.generate > 0) {
+    if (!native.addon) throw new Error(`engine addon unavailable: ${native.loadError && native.loadError.message}`);
+    const { generateGraph } = require('./graph_gen');
+    plan = generateGraph(JSON.parse(native.addon.catalog()), { nodes: opts.generate, seed: opts.seed, exclude: ['LuaScript'] });
+  } else {
+    throw new Error('need --plan <file> or --generate <nodes>');
+  }
+
+  const t0 = process.hrtime.bigint();
+  const g = await ShardedGraph.create(plan, { shards: opts.shards, imbalance: opts.imbalance });
+  const ms = (from) => Math.round(Number(process.hrtime.bigint() - from) / 1e3) / 1e3;
+  const report = { ...g.stats, load_ms: ms(t0), run_ms: [] };
+  let outputs;
+  try {
+    for (let r = 0; r < Math.max(1, opts.runs); r++) {
+      const t = process.hrtime.bigint();
+      outputs = await g.run();
+      report.run_ms.push(ms(t));
+    }
+  } finally {
+    await g.close();
+  }
+  report.outputs = outputs.length;
+  if (opts.check) {
+    const local = (await native.runPlan(plan)).outputs;
+    const differ = local.filter((o, i) => o.type !== outputs[i].type || !Object.is(o.value, outputs[i].value)).length;
+    report.check = differ ? `${differ} outputs differ` : 'ok';
+  }
+  console.log(JSON.stringify(report));
+  if (report.check && report.check !== 'ok') process.exitCode = 1;
+}
+
+if (require.main === module) {
+  main().catch((err) => {
+    console.error(`shard_coordinator: ${err.message || err}`);
+    process.exit(1);
+  });
+}
+
+module.exports = { ShardedGraph, buildShards };
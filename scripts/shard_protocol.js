@@ -0,0 +1,42 @@
+// Wire format between shard_coordinator.js and shard_worker.js: JSON
+// messages in length-prefixed frames (u32be length | UTF-8 JSON) over a Unix
+// domain socket, the same framing the LuaJIT worker pool uses on its pipes.
+//
+// Engine values cross the wire as { type, value }. JSON has no NaN,
+// infinities or negative zero, so those travel as
+// { type: 'number', special: 'NaN' | 'Infinity' | '-Infinity' | '-0' }.
+
+function writeFrame(socket, msg) {
+  const body = Buffer.from(JSON.stringify(msg), 'utf8');
+  const header = Buffer.alloc(4);
+  header.writeUInt32BE(body.length, 0);
+  socket.write(Buffer.concat([header, body]));
+}
+
+// Calls onMessage(msg) for every complete frame read from `socket`.
+function readFrames(socket, onMessage) {
+  let buf = Buffer.alloc(0);
+  socket.on('data', (chunk) => {
+    buf = buf.length ? Buffer.concat([buf, chunk]) : chunk;
+    while (buf.length >= 4) {
+      const n = buf.readUInt32BE(0);
+      if (buf.length < 4 + n) break;
+      const body = buf.subarray(4, 4 + n).toString('utf8');
+      buf = buf.subarray(4 + n);
+      onMessage(JSON.parse(body));
+    }
+  });
+}
+
+function encodeValue(type, value) {
+  if (type === 'number' && (!Number.isFinite(value) || Object.is(value, -0))) {
+    return { type, special: Object.is(value, -0) ? '-0' : String(value) };
+  }
+  return { type, value };
+}
+
+function decodeValue(v) {
+  return v.special !== undefined ? Number(v.special) : v.value;
+}
+
+module.exports = { writeFrame, readFrames, encodeValue, decodeValue };
@@ -0,0 +1,72 @@
+#!/usr/bin/env node
+// One shard of a sharded graph (see shard_coordinator.js).
+//
+//   node scripts/shard_worker.js <coordinator socket> <shard index>
+//
+// Connects to the coordinator's Unix socket, announces itself with
+// {type:'hello', shard} and then serves requests one at a time, each answered
+// with {id, ok: true, ...} or {id, ok: false, error}:
+//   {type:'load', plan, imports:[{node, key}]}  build the shard's resident graph;
+//       imports[i] is the parameter of the placeholder source node that
+//       carries boundary value i from an upstream shard
+//   {type:'run', inputs:[value|null], params:[{node, key, value}]}
+//       set changed boundary values (null = unchanged) and parameters, run,
+//       and reply {outputs:[value, ...]} for the shard's output pins
+//   {type:'close'}  dispose the graph and exit
+// The graph stays resident between runs, so the engine only recomputes what
+// the new inputs and parameters affect.
+const net = require('net');
+const native = require('./engine_native');
+const { writeFrame, readFrames, encodeValue, decodeValue } = require('./shard_protocol');
+
+const [socketPath, shardArg] = process.argv.slice(2);
+if (!socketPath || shardArg === undefined) {
+  console.error('usage: shard_worker.js <socket> <shard>');
+  process.exit(2);
+}
+
+let graph = null;
+let imports = [];
+
+async function handle(msg) {
+  if (msg.type === 'load') {
+    if (!native.addon) throw new Error(`engine addon unavailable: ${native.loadError && native.loadError.message}`);
+    if (graph) graph.dispose();
+    graph = null;
+    graph = native.buildGraph(msg.plan);
+    imports = msg.imports || [];
+    return {};
+  }
+  if (msg.type === 'run') {
+    if (!graph) throw new Error('no shard loaded');
+    (msg.inputs || []).forEach((v, i) => {
+      if (v !== null) graph.setParam(imports[i].node, imports[i].key, decodeValue(v));
+    });
+    for (const p of msg.params || []) graph.setParam(p.node, p.key, native.paramValue(p.value));
+    const outputs = await graph.run();
+    return { outputs: outputs.map((o) => encodeValue(o.type, o.value)) };
+  }
+  throw new Error(`unknown request '${msg.type}'`);
+}
+
+const socket = net.createConnection(socketPath, () => writeFrame(socket, { type: 'hello', shard: Number(shardArg) }));
+let queue = Promise.resolve();
+readFrames(socket, (msg) => {
+  if (msg.type === 'close') {
+    if (graph) graph.dispose();
+    socket.end();
+    return;
+  }
+  queue = queue.then(async () => {
+    try {
+      writeFrame(socket, { id: msg.id, ok: true, ...(await handle(msg)) });
+    } catch (err) {
+      writeFrame(socket, { id: msg.id, ok: false, error: String(err.message || err) });
+    }
+  });
+});
+socket.on('error', (err) => {
+  console.error(`shard ${shardArg}: ${err.message}`);
+  process.exit(1);
+});
+socket.on('close', () => process.exit(0));
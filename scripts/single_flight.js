@@ -0,0 +1,89 @@
+const crypto = require('crypto');
+const { paramValue } = require('./engine_native');
+
+// Request coalescing for /run.
+//
+// Identical plans that arrive while one of them is executing attach to that
+// run's result instead of starting their own. Optionally, results of fully
+// deterministic plans are kept for a short TTL so a refresh storm that
+// straddles the end of a run is also served from memory.
+
+// Hash of a plan after normalization: formatting, JSON key order, node order
+// and numeric-string params ("2" vs 2) do not change the key. Edge and output
+// order do, since they affect input slots and output indices.
+function planKey(plan) {
+  const h = crypto.createHash('sha1');
+  if (typeof plan === 'string') {
+    h.update('t');
+    for (const line of plan.split(/\r?\n/)) {
+      const l = line.trim().replace(/\s+/g, ' ');
+      if (l) h.update(l + '\n');
+    }
+    return h.digest('hex');
+  }
+  const nodes = (plan.nodes || []).slice().sort((a, b) => a.id - b.id);
+  h.update(`j${plan.version}`);
+  for (const n of nodes) {
+    const params = n.params || {};
+    const kv = Object.keys(params).sort().map((k) => [k, paramValue(params[k])]);
+    h.update(`n${n.id}:${n.type}${JSON.stringify(kv)}`);
+  }
+  for (const e of (plan.edges && plan.edges.data) || []) {
+    h.update(`e${e.from}.${e.fromOutput || 0}>${e.to}.${e.toInput || 0}`);
+  }
+  for (const o of plan.outputs || []) h.update(`o${o.node}.${o.output || 0}`);
+  return h.digest('hex');
+}
+
+class SingleFlight {
+  constructor({ ttlMs = 0, maxEntries = 1024 } = {}) {
+    this.ttlMs = ttlMs;
+    this.maxEntries = maxEntries;
+    this.inflight = new Map(); // key -> Promise
+    this.results = new Map(); // key -> { expires, value }; insertion order = age
+    this.stats = { runs: 0, joined: 0, cached: 0 };
+  }
+
+  // Resolves to { value, source } with source 'run', 'joined' or 'cache'.
+  // fn() must resolve to a value that is safe to share between requests;
+  // only values for which cacheable(value) holds are kept, and only when the
+  // plan is deterministic.
+  async run(key, deterministic, fn, cacheable = () => true) {
+    const hit = this.results.get(key);
+    if (hit) {
+      if (hit.expires > Date.now()) {
+        this.stats.cached++;
+        return { value: hit.value, source: 'cache' };
+      }
+      this.results.delete(key);
+    }
+
+    const pending = this.inflight.get(key);
+    if (pending) {
+      this.stats.joined++;
+      return { value: await pending, source: 'joined' };
+    }
+
+    this.stats.runs++;
+    const p = fn();
+    this.inflight.set(key, p);
+    try {
+      const value = await p;
+      if (deterministic && this.ttlMs > 0 && cacheable(value)) this._remember(key, value);
+      return { value, source: 'run' };
+    } finally {
+      this.inflight.delete(key);
+    }
+  }
+
+  _remember(key, value) {
+    const now = Date.now();
+    for (const [k, e] of this.results) {
+      if (e.expires > now && this.results.size < this.maxEntries) break;
+      this.results.delete(k); // expired or over capacity, oldest first
+    }
+    this.results.set(key, { expires: now + this.ttlMs, value });
+  }
+}
+
+module.exports = { SingleFlight, planKey };
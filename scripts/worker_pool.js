@@ -0,0 +1,108 @@
+const { spawn } = require('child_process');
+
+// Pool of long-lived `luajit run_graph.lua --worker` processes.
+//
+// Each worker loads libengine.so once and then serves length-prefixed frames
+// over stdin/stdout (see the worker-mode comment in scripts/lua/run_graph.lua):
+//   request:  u32be length | op byte | body
+//   response: u32be length | '0' ok / '1' error | JSON
+// A worker handles one request at a time; extra requests wait in a FIFO queue.
+// Workers that exit are respawned and their in-flight request is failed.
+class WorkerPool {
+  constructor({ command, args, cwd, env, size }) {
+    this.command = command;
+    this.args = args;
+    this.cwd = cwd;
+    this.env = env;
+    this.size = Math.max(1, size | 0);
+    this.workers = [];
+    this.idle = [];
+    this.queue = [];
+    this.closed = false;
+    for (let i = 0; i < this.size; i++) this._spawn(i);
+  }
+
+  // Resolves to { ok, body } where body is the worker's JSON text.
+  request(op, body = '') {
+    return new Promise((resolve, reject) => {
+      this.queue.push({ op, body: Buffer.from(body, 'utf8'), resolve, reject });
+      this._dispatch();
+    });
+  }
+
+  get pending() {
+    return this.queue.length;
+  }
+
+  close() {
+    this.closed = true;
+    for (const w of this.workers) if (w) w.proc.kill();
+    for (const job of this.queue.splice(0)) job.reject(new Error('worker pool closed'));
+  }
+
+  _spawn(slot) {
+    const proc = spawn(this.command, this.args, {
+      cwd: this.cwd,
+      env: this.env,
+      stdio: ['pipe', 'pipe', 'pipe'],
+    });
+    const w = { slot, proc, buf: Buffer.alloc(0), job: null, startedAt: Date.now() };
+    this.workers[slot] = w;
+
+    proc.stdout.on('data', (chunk) => this._onData(w, chunk));
+    proc.stderr.on('data', (chunk) => {
+      for (const line of String(chunk).split('\n')) if (line) process.stderr.write(`[worker ${slot}] ${line}\n`);
+    });
+    proc.stdin.on('error', () => {}); // surfaced through 'exit'
+    proc.on('error', (err) => this._onExit(w, err));
+    proc.on('exit', (code, signal) => this._onExit(w, new Error(`worker exited (${signal || code})`)));
+
+    this.idle.push(w);
+    this._dispatch();
+  }
+
+  _onExit(w, err) {
+    if (this.workers[w.slot] !== w) return; // already replaced
+    this.workers[w.slot] = null;
+    this.idle = this.idle.filter((x) => x !== w);
+    if (w.job) {
+      w.job.reject(err);
+      w.job = null;
+    }
+    if (this.closed) return;
+    // Back off if the worker died right after starting (e.g. libengine.so missing)
+    const delay = Date.now() - w.startedAt < 1000 ? 1000 : 0;
+    setTimeout(() => { if (!this.closed) this._spawn(w.slot); }, delay);
+  }
+
+  _onData(w, chunk) {
+    w.buf = w.buf.length ? Buffer.concat([w.buf, chunk]) : chunk;
+    while (w.buf.length >= 4) {
+      const n = w.buf.readUInt32BE(0);
+      if (w.buf.length < 4 + n) break;
+      const payload = w.buf.subarray(4, 4 + n);
+      w.buf = w.buf.subarray(4 + n);
+      const job = w.job;
+      w.job = null;
+      if (job) {
+        job.resolve({ ok: payload[0] === 0x30 /* '0' */, body: payload.subarray(1).toString('utf8') });
+      }
+      this.idle.push(w);
+    }
+    this._dispatch();
+  }
+
+  _dispatch() {
+    while (this.idle.length && this.queue.length) {
+      const w = this.idle.shift();
+      const job = this.queue.shift();
+      w.job = job;
+      const header = Buffer.alloc(5);
+      header.writeUInt32BE(job.body.length + 1, 0);
+      header[4] = job.op.charCodeAt(0);
+      w.proc.stdin.write(Buffer.concat([header, job.body]));
+    }
+  }
+}
+
+module.exports = { WorkerPool };